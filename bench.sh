@@ -0,0 +1,94 @@
+#!/bin/sh
+#
+# Dynamic MPI Mandelbrot algorithm
+# Copyright (C) 2015  Martin Ohmann <martin@mohmann.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+# 
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+#
+# benchmark harness, run by 'make bench'. renders a fixed set of views for 
+# all combinations of process counts, block sizes and iteration maxima and 
+# appends the statistics of every run to a csv file, together with the view,
+# commit and host. settings are taken from the environment:
+#
+#     MPIRUN      command to start MPI programs (default: mpirun)
+#     PROCS       # of processes (default: 2 3 5)
+#     BLOCKSIZES  arguments of '-b' (default: 1 16)
+#     ITERATIONS  arguments of '-n' (default: 1000 10000)
+#     SIZE        image width & height (default: 1024)
+#     VIEWS       views to render (default: full seahorse interior deep)
+#     ARGS        additional arguments of every run
+#     OUTPUT      csv file the results are appended to (default: bench.csv)
+#
+
+MPIRUN=${MPIRUN:-mpirun}
+PROCS=${PROCS:-2 3 5}
+BLOCKSIZES=${BLOCKSIZES:-1 16}
+ITERATIONS=${ITERATIONS:-1000 10000}
+SIZE=${SIZE:-1024}
+VIEWS=${VIEWS:-full seahorse interior deep}
+OUTPUT=${OUTPUT:-bench.csv}
+
+# arguments of the standard views. the interior view lies inside the main 
+# cardioid, whose points are iterated instead of skipped by the cardioid check
+view_args() {
+    case $1 in
+        full)     echo "-x -0.5 -y 0 -a 1.5" ;;
+        seahorse) echo "-x -0.75 -y 0.1 -a 0.05" ;;
+        interior) echo "-x -0.2 -y 0 -a 0.3 --no-cardioid" ;;
+        deep)     echo "-x -0.743643887037158704752191506114774" \
+                       "-y 0.131825904205311970493132056385139 -a 1e-20 --deep" ;;
+        *)        return 1 ;;
+    esac
+}
+
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+host=$(hostname)
+stats=$(mktemp) || exit 1
+image=$(mktemp) || exit 1
+
+trap 'rm -f "$stats" "$image"' EXIT
+
+for view in $VIEWS; do
+    if ! args=$(view_args "$view"); then
+        echo "Error: unknown view '$view'." >&2
+        exit 1
+    fi
+
+    for procs in $PROCS; do
+        for blocksize in $BLOCKSIZES; do
+            for iterations in $ITERATIONS; do
+                echo "$view: $procs processes, blocksize $blocksize, $iterations iterations"
+
+                : > "$stats"
+
+                if ! $MPIRUN -np "$procs" ./mandelbrot $args -c "$SIZE" -r "$SIZE" \
+                        -b "$blocksize" -n "$iterations" -o "$image" --stats "$stats" \
+                        $ARGS > /dev/null; then
+                    echo "Error: benchmark run failed." >&2
+                    exit 1
+                fi
+
+                if [ ! -s "$OUTPUT" ]; then
+                    echo "view,commit,host,$(head -n 1 "$stats")" > "$OUTPUT"
+                fi
+
+                echo "$view,$commit,$host,$(tail -n 1 "$stats")" >> "$OUTPUT"
+            done
+        done
+    done
+done
+
+echo "Finished. Results appended to '$OUTPUT'."
@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+# Dynamic MPI Mandelbrot algorithm
+# Copyright (C) 2015  Martin Ohmann <martin@mohmann.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+#
+# regression checks, run by 'make check'. renders views after others which
+# share state with them (e.g. the tile cache) and compares the bitmaps with
+# those of renders from scratch. settings are taken from the environment:
+#
+#     MPIRUN      command to start MPI programs (default: mpirun)
+#     PROCS       # of processes (default: 3)
+#
+
+MPIRUN=${MPIRUN:-mpirun}
+PROCS=${PROCS:-3}
+
+dir=$(mktemp -d) || exit 1
+failed=0
+
+trap 'rm -rf "$dir"' EXIT
+
+# render into $dir/$1 with the remaining arguments
+render() {
+    name=$1
+    shift
+
+    if ! $MPIRUN -np "$PROCS" ./mandelbrot -o "$dir/$name" "$@" > /dev/null; then
+        echo "Error: render of '$name' failed." >&2
+        exit 1
+    fi
+}
+
+# compare two bitmaps of $dir, $3 describes the check
+compare() {
+    if cmp -s "$dir/$1" "$dir/$2"; then
+        echo "ok      $3"
+    else
+        echo "FAILED  $3"
+        failed=1
+    fi
+}
+
+# the seahorse valley holds pixels of the cardioid, of periodic orbits and
+# escaping ones
+view="-c 256 -r 256 -x -0.75 -y 0.1 -a 0.5"
+
+render cached-500.bmp $view -n 500 --cache "$dir/raise"
+render cached-1500.bmp $view -n 1500 --cache "$dir/raise"
+render fresh-1500.bmp $view -n 1500 --cache "$dir/fresh-1500"
+compare cached-1500.bmp fresh-1500.bmp "raising '-n' on a cached view"
+
+render cached-300.bmp $view -n 300 --cache "$dir/raise"
+render fresh-300.bmp $view -n 300 --cache "$dir/fresh-300"
+compare cached-300.bmp fresh-300.bmp "lowering '-n' on a cached view"
+
+render panned.bmp $view -n 500 -x -0.6 --cache "$dir/pan"
+render unpanned.bmp $view -n 500 --cache "$dir/pan"
+render fresh-500.bmp $view -n 500 --cache "$dir/fresh-500"
+compare unpanned.bmp fresh-500.bmp "panning over a cached view"
+
+if [ $failed -ne 0 ]; then
+    echo "Error: regression checks failed." >&2
+    exit 1
+fi
+
+echo "Finished. All regression checks passed."
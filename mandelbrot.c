@@ -17,16 +17,91 @@
  */
 #include "mandelbrot.h"
 
+/*
+ * names of render modes, indexed by MO_MODE_*
+ */
+static const char *modes[MO_MODES] = { "rows", "mariani", "progressive" };
+
+/*
+ * names of precisions, indexed by MO_PREC_*
+ */
+static const char *precisions[MO_PRECS] = { "float", "double", "long" };
+
+/*
+ * names of block size schedules, indexed by MO_SCHED_*
+ */
+static const char *schedules[MO_SCHEDS] = { "guided", "fixed", "static" };
+
+/*
+ * names of trace events
+ */
+static const char *event_types[MO_EVENTS] = { "compute", "recv", "send", "color", "decode", 
+    "write" };
+
+/*
+ * rules on combining features, checked in this order. most features are 
+ * handled by the master in ways of their own, which leave out the parts the
+ * others depend on: the master writes the frames of sequences and the 
+ * requests of the render server, looks up and writes cache entries, merges the 
+ * passes of the progressive mode and records the blocks of checkpoints. 
+ * tiles of the pyramid are written by the slaves. symmetry needs the same 
+ * view for all blocks, whose rows pass through the master
+ */
+static const mo_rule_t rules[] = {
+    /* the cardioid and bulb are those of the mandelbrot set. perturbation and the
+     * cache iterate the mandelbrot set in code of their own */
+    { MO_FEAT_FORMULA, MO_FEAT_DEEP | MO_FEAT_CACHE, 0, 
+        "'--power', '--burning-ship' and '--julia' cannot be combined with '--deep' or " 
+        "'--cache'." },
+    { MO_FEAT_KEYFRAMES, MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_DEEP, 0, 
+        "'--keyframes' cannot be combined with '--mpi-io', '--rma' or '--deep'." },
+    { MO_FEAT_SERVE, MO_FEAT_KEYFRAMES | MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_DEEP | 
+        MO_FEAT_CACHE | MO_FEAT_CHECKPOINT | MO_FEAT_TILES | MO_FEAT_PROGRESSIVE | 
+        MO_FEAT_STATIC, 0, 
+        "'--serve' cannot be combined with '--keyframes', '--mpi-io', '--rma', '--deep', " 
+        "'--cache', '--checkpoint', '--tiles', '--mode progressive' or '--schedule static'." },
+    { MO_FEAT_CACHE, MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_DEEP | MO_FEAT_KEYFRAMES, 0, 
+        "'--cache' cannot be combined with '--mpi-io', '--rma', '--deep' or '--keyframes'." },
+    { MO_FEAT_CACHE, MO_FEAT_ANTIALIAS, 0, 
+        "'--cache' cannot be combined with '--antialias'." },
+    { MO_FEAT_TILES, MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_CACHE | MO_FEAT_KEYFRAMES | 
+        MO_FEAT_CHECKPOINT | MO_FEAT_PROGRESSIVE | MO_FEAT_STATIC, 0, 
+        "'--tiles' cannot be combined with '--mpi-io', '--rma', '--cache', '--keyframes', " 
+        "'--checkpoint', '--mode progressive' or '--schedule static'." },
+    /* the static schedule is planned by the master for the first frame only */
+    { MO_FEAT_STATIC, MO_FEAT_RMA | MO_FEAT_CHECKPOINT | MO_FEAT_KEYFRAMES, 0, 
+        "'--schedule static' cannot be combined with '--rma', '--checkpoint' or " 
+        "'--keyframes'." },
+    { MO_FEAT_PROGRESSIVE, MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_CACHE | 
+        MO_FEAT_CHECKPOINT | MO_FEAT_KEYFRAMES | MO_FEAT_STATIC, 0, 
+        "'--mode progressive' cannot be combined with '--mpi-io', '--rma', '--cache', " 
+        "'--checkpoint', '--keyframes' or '--schedule static'." },
+    /* node leaders split the chunks of the master by the guided schedule and pass 
+     * on the raw values of the workers, which the master decodes and writes */
+    { MO_FEAT_HIERARCHICAL, MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_CACHE | MO_FEAT_TILES | 
+        MO_FEAT_SERVE | MO_FEAT_COMPRESS | MO_FEAT_PROGRESSIVE | MO_FEAT_FIXED | 
+        MO_FEAT_STATIC, 0, 
+        "'--hierarchical' requires '--schedule guided' and cannot be combined with " 
+        "'--mpi-io', '--rma', '--cache', '--tiles', '--serve', '-z' or '--mode progressive'." },
+    { MO_FEAT_CHECKPOINT, MO_FEAT_MPIIO | MO_FEAT_RMA, 0, 
+        "'--checkpoint' cannot be combined with '--mpi-io' or '--rma'." },
+    { MO_FEAT_RESUME, 0, MO_FEAT_CHECKPOINT, 
+        "'--resume' requires '--checkpoint'." },
+    { MO_FEAT_SYMMETRY, MO_FEAT_DEEP | MO_FEAT_MPIIO | MO_FEAT_RMA | MO_FEAT_TILES | 
+        MO_FEAT_CACHE | MO_FEAT_KEYFRAMES | MO_FEAT_SERVE | MO_FEAT_PROGRESSIVE | 
+        MO_FEAT_STATIC, 0, NULL }
+};
+
 /* 
  * main
  */
 int main(int argc, char **argv) 
 {
-    int proc_count, proc_id, retval;
+    int proc_count, proc_id, retval, thread_level;
     mo_opts_t *opts;
 
-    /* initialize MPI */
-    if (MPI_Init(&argc, &argv) != MPI_SUCCESS) {
+    /* initialize MPI, only the main thread of each process communicates */
+    if (MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_level) != MPI_SUCCESS) {
         eprintf("MPI initialization failed.\n");
         exit(EXIT_FAILURE);
     }
@@ -34,11 +109,6 @@ int main(int argc, char **argv)
     /* get number of avaiable processes */
     MPI_Comm_size(MPI_COMM_WORLD, &proc_count);
 
-    if (proc_count < 2) {
-        eprintf("Number of processes must be at least 2.\n");
-        finalize_exit(EXIT_FAILURE);
-    }
-
     /* get current process id */
     MPI_Comm_rank(MPI_COMM_WORLD, &proc_id);
 
@@ -51,16 +121,71 @@ int main(int argc, char **argv)
 
     /* parse args and store them in opts */
     retval = parse_args(argc, argv, opts, proc_id, proc_count);
+
+    if (retval == EXIT_SUCCESS && opts->threads > 1 && thread_level < MPI_THREAD_FUNNELED) {
+        if (proc_id == 0) {
+            eprintf("MPI implementation does not support threads.\n");
+        }
+        retval = EXIT_FAILURE;
+    }
     
+    /* deep zoom needs the reference orbit on all processes */
+    if (retval == EXIT_SUCCESS && opts->deep) {
+        retval = reference_orbit(proc_id, opts);
+    }
+
+    /* event times are taken relative to a common start */
+    if (retval == EXIT_SUCCESS && opts->trace != NULL) {
+        MPI_Barrier(MPI_COMM_WORLD);
+        opts->trace->origin = MPI_Wtime();
+    }
+
     if (retval == EXIT_SUCCESS) {
-        /* depending on process id run as master (0) or slave (n) */
-        if (proc_id == 0) {
-            retval = master_proc(proc_count - 1, opts);
+        /* depending on process id run as master (0) or slave (n), unless all
+         * processes schedule themselves. the render server runs them once per 
+         * batch of requests */
+        if (opts->serve != NULL) {
+            retval = serve(proc_id, proc_count, opts);
+        } else if (opts->rma) {
+            retval = rma_proc(proc_id, opts);
+        } else if (proc_id == 0) {
+            retval = master_proc((opts->node_count > 0) ? opts->node_count : proc_count - 1, 
+                    opts);
+        } else if (opts->node_comm != MPI_COMM_NULL) {
+            retval = node_proc(opts);
         } else {
-            retval = slave_proc(proc_id, opts);
+            retval = slave_proc(opts);
         }
     }
 
+    /* all processes take part, even if the computation failed */
+    if (opts->stats_file != NULL) {
+        report_stats(proc_id, proc_count, opts);
+    }
+
+    if (opts->trace != NULL) {
+        write_trace(proc_id, proc_count, opts);
+        free(opts->trace->events);
+        free(opts->trace);
+    }
+
+    if (opts->orbit != NULL) {
+        free(opts->orbit->re);
+        free(opts->orbit);
+    }
+
+    free(opts->keyframes);
+    free(opts->mirrored);
+
+    /* workers talk to their leader on the communicator of their node */
+    if (opts->node_comm != MPI_COMM_NULL && opts->node_comm != opts->comm) {
+        MPI_Comm_free(&opts->node_comm);
+    }
+
+    if (opts->comm != MPI_COMM_WORLD) {
+        MPI_Comm_free(&opts->comm);
+    }
+
     free(opts);
     MPI_Finalize();
 
@@ -81,13 +206,94 @@ static int parse_args(int argc, char **argv, mo_opts_t *opts, int proc_id, int p
     opts->max_color = MO_COLORMAX;
     opts->color_mask = MO_COLORMASK;
     opts->blocksize = MO_BLOCKSIZE;
+    opts->block_width = MO_BLOCKWIDTH;
+    opts->schedule = MO_SCHEDULE;
     opts->show_progress = MO_PROGRESS;
+    opts->kernel = MO_KERNEL;
+    opts->threads = MO_THREADS;
+    opts->depth = MO_DEPTH;
+    opts->compress = MO_COMPRESS;
+    opts->cardioid = MO_CARDIOID;
+    opts->periodicity = MO_PERIODICITY;
+    opts->power = MO_POWER;
+    opts->burning_ship = 0;
+    opts->julia = 0;
+    opts->julia_re = opts->julia_im = 0;
+    opts->formula = 0;
+    opts->symmetry = MO_SYMMETRY;
+    opts->mirror = 0;
+    opts->mirrored = NULL;
+    opts->mode = MO_MODE_ROWS;
+    opts->antialias = MO_ANTIALIAS;
+    opts->mpi_io = MO_MPIIO;
+    opts->rma = MO_RMA;
+    opts->hierarchical = MO_HIERARCHICAL;
+    opts->node_count = 0;
+    opts->comm = MPI_COMM_WORLD;
+    opts->node_comm = MPI_COMM_NULL;
+    opts->node_win = MPI_WIN_NULL;
+    opts->node_buffers = NULL;
+    opts->deep = MO_DEEP;
+    opts->precision = MO_PREC_AUTO;
+    opts->keyframes = NULL;
+    opts->keyframe_count = 0;
+    opts->frame_count = 1;
+    opts->x_str = "0";
+    opts->y_str = "0";
+    opts->orbit = NULL;
+    opts->cache_dir = NULL;
+    opts->tiles = NULL;
+    opts->tile_levels = 0;
+    opts->serve = NULL;
+    opts->requests = NULL;
+    opts->server = NULL;
+    opts->lattice_col = 0;
+    opts->lattice_row = 0;
+    opts->checkpoint = NULL;
+    opts->checkpoint_interval = MO_CKPTINTERVAL;
+    opts->resume = 0;
+    opts->stats_file = NULL;
+    opts->trace = NULL;
+    opts->instrument = 0;
+    opts->partition = NULL;
+    memset(&opts->stats, 0, sizeof(opts->stats));
 
     double x_offset = 0;
     double y_offset = 0;
     double axis_length = MO_N;
+    const char *keyframes = NULL;
+    const char *trace = NULL;
 
-    const char *opt_string = "c:r:n:hb:p:q:m:x:y:a:o:s";
+    const char *opt_string = "c:r:n:hb:w:p:q:m:x:y:a:o:sk:t:d:z";
+
+    /* options without short equivalent */
+    const struct option long_opts[] = {
+        { "no-cardioid", no_argument, NULL, MO_OPT_NO_CARDIOID },
+        { "no-periodicity", no_argument, NULL, MO_OPT_NO_PERIODICITY },
+        { "no-symmetry", no_argument, NULL, MO_OPT_NO_SYMMETRY },
+        { "power", required_argument, NULL, MO_OPT_POWER },
+        { "burning-ship", no_argument, NULL, MO_OPT_BURNING_SHIP },
+        { "julia", required_argument, NULL, MO_OPT_JULIA },
+        { "mode", required_argument, NULL, MO_OPT_MODE },
+        { "mpi-io", no_argument, NULL, MO_OPT_MPIIO },
+        { "schedule", required_argument, NULL, MO_OPT_SCHEDULE },
+        { "rma", no_argument, NULL, MO_OPT_RMA },
+        { "hierarchical", no_argument, NULL, MO_OPT_HIERARCHICAL },
+        { "deep", no_argument, NULL, MO_OPT_DEEP },
+        { "precision", required_argument, NULL, MO_OPT_PRECISION },
+        { "keyframes", required_argument, NULL, MO_OPT_KEYFRAMES },
+        { "frames", required_argument, NULL, MO_OPT_FRAMES },
+        { "cache", required_argument, NULL, MO_OPT_CACHE },
+        { "checkpoint", required_argument, NULL, MO_OPT_CHECKPOINT },
+        { "checkpoint-interval", required_argument, NULL, MO_OPT_CKPTINTERVAL },
+        { "resume", no_argument, NULL, MO_OPT_RESUME },
+        { "stats", required_argument, NULL, MO_OPT_STATS },
+        { "trace", required_argument, NULL, MO_OPT_TRACE },
+        { "antialias", required_argument, NULL, MO_OPT_ANTIALIAS },
+        { "tiles", required_argument, NULL, MO_OPT_TILES },
+        { "serve", required_argument, NULL, MO_OPT_SERVE },
+        { NULL, 0, NULL, 0 }
+    };
 
     int optval_int, c, index;
     long optval_long;
@@ -97,12 +303,15 @@ static int parse_args(int argc, char **argv, mo_opts_t *opts, int proc_id, int p
     opterr = 0;
 
     /* start parsing args */
-    while ((c = getopt(argc, argv, opt_string)) != -1) {
+    while ((c = getopt_long(argc, argv, opt_string, long_opts, NULL)) != -1) {
         switch (c) {
             case 'b': /* blocksize */
+            case 'w': /* block width */
             case 'c': /* width */
             case 'r': /* height */
             case 'n': /* iterations */
+            case 't': /* threads */
+            case 'd': /* depth */
                 optval_int = atoi(optarg);
 
                 if (optval_int <= 0) {
@@ -116,7 +325,10 @@ static int parse_args(int argc, char **argv, mo_opts_t *opts, int proc_id, int p
                 if (c == 'c') opts->width = optval_int; else
                 if (c == 'r') opts->height = optval_int; else
                 if (c == 'n') opts->max_iterations = optval_int; else
-                if (c == 'b') opts->blocksize = optval_int;
+                if (c == 'b') opts->blocksize = optval_int; else
+                if (c == 'w') opts->block_width = optval_int; else
+                if (c == 't') opts->threads = optval_int; else
+                if (c == 'd') opts->depth = optval_int;
                 break;
             case 'p': /* colormin */
             case 'q': /* colormax */
@@ -132,8 +344,8 @@ static int parse_args(int argc, char **argv, mo_opts_t *opts, int proc_id, int p
             case 'a': /* axis-length */
                 optval_double = atof(optarg);
 
-                if (c == 'x') x_offset = optval_double; else
-                if (c == 'y') y_offset = optval_double; else
+                if (c == 'x') { x_offset = optval_double; opts->x_str = optarg; } else
+                if (c == 'y') { y_offset = optval_double; opts->y_str = optarg; } else
                 if (c == 'a') { 
                     if (optval_double == 0) {
                         if (proc_id == 0) {
@@ -151,6 +363,162 @@ static int parse_args(int argc, char **argv, mo_opts_t *opts, int proc_id, int p
             case 's': /* progress */
                 opts->show_progress = 1;
                 break;
+            case 'z': /* compression */
+                opts->compress = 1;
+                break;
+            case MO_OPT_NO_CARDIOID:
+                opts->cardioid = 0;
+                break;
+            case MO_OPT_NO_PERIODICITY:
+                opts->periodicity = 0;
+                break;
+            case MO_OPT_NO_SYMMETRY:
+                opts->symmetry = 0;
+                break;
+            case MO_OPT_POWER:
+                opts->power = atoi(optarg);
+
+                if (opts->power < 2 || opts->power > MO_MAXPOWER) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("argument of '--power' has to be between 2 and %d.\n", 
+                            MO_MAXPOWER);
+                    }
+                    return EXIT_FAILURE;
+                }
+                break;
+            case MO_OPT_BURNING_SHIP:
+                opts->burning_ship = 1;
+                break;
+            case MO_OPT_JULIA:
+                if (sscanf(optarg, "%Lf,%Lf", &opts->julia_re, &opts->julia_im) != 2) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("argument of '--julia' has to be of the form 're,im'.\n");
+                    }
+                    return EXIT_FAILURE;
+                }
+                opts->julia = 1;
+                break;
+            case MO_OPT_MPIIO:
+                opts->mpi_io = 1;
+                break;
+            case MO_OPT_RMA:
+                opts->rma = 1;
+                break;
+            case MO_OPT_HIERARCHICAL:
+                opts->hierarchical = 1;
+                break;
+            case MO_OPT_DEEP:
+                opts->deep = 1;
+                break;
+            case MO_OPT_KEYFRAMES:
+                keyframes = optarg;
+                break;
+            case MO_OPT_CACHE:
+                opts->cache_dir = optarg;
+                break;
+            case MO_OPT_TILES:
+                opts->tiles = optarg;
+                break;
+            case MO_OPT_SERVE:
+                opts->serve = optarg;
+                break;
+            case MO_OPT_CHECKPOINT:
+                opts->checkpoint = optarg;
+                break;
+            case MO_OPT_CKPTINTERVAL:
+                opts->checkpoint_interval = atof(optarg);
+
+                if (opts->checkpoint_interval <= 0) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("argument of '--checkpoint-interval' has to be greater " \
+                            "than zero.\n");
+                    }
+                    return EXIT_FAILURE;
+                }
+                break;
+            case MO_OPT_RESUME:
+                opts->resume = 1;
+                break;
+            case MO_OPT_STATS:
+                opts->stats_file = optarg;
+                break;
+            case MO_OPT_TRACE:
+                trace = optarg;
+                break;
+            case MO_OPT_ANTIALIAS:
+                opts->antialias = atoi(optarg);
+
+                if (opts->antialias <= 0 || opts->antialias > MO_MAXANTIALIAS) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("argument of '--antialias' has to be between 1 and %d.\n", 
+                            MO_MAXANTIALIAS);
+                    }
+                    return EXIT_FAILURE;
+                }
+                break;
+            case MO_OPT_FRAMES:
+                opts->frame_count = atoi(optarg);
+
+                if (opts->frame_count <= 0) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("argument of '--frames' has to be greater than zero.\n");
+                    }
+                    return EXIT_FAILURE;
+                }
+                break;
+            case MO_OPT_PRECISION:
+                for (index = 0; index < MO_PRECS && strcmp(optarg, precisions[index]) != 0; 
+                    ++index);
+
+                if (index == MO_PRECS && strcmp(optarg, "auto") != 0) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("unknown precision '%s'.\n", optarg);
+                    }
+                    return EXIT_FAILURE;
+                }
+                opts->precision = (index == MO_PRECS) ? MO_PREC_AUTO : index;
+                break;
+            case MO_OPT_MODE:
+                for (index = 0; index < MO_MODES && strcmp(optarg, modes[index]) != 0; ++index);
+
+                if (index == MO_MODES) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("unknown mode '%s'.\n", optarg);
+                    }
+                    return EXIT_FAILURE;
+                }
+                opts->mode = index;
+                break;
+            case MO_OPT_SCHEDULE:
+                for (index = 0; index < MO_SCHEDS && strcmp(optarg, schedules[index]) != 0; 
+                    ++index);
+
+                if (index == MO_SCHEDS) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("unknown schedule '%s'.\n", optarg);
+                    }
+                    return EXIT_FAILURE;
+                }
+                opts->schedule = index;
+                break;
+            case 'k': /* kernel */
+                if (select_kernel(optarg, MO_PREC_DOUBLE, 0) == NULL) {
+                    if (proc_id == 0) {
+                        print_usage(argv);
+                        eprintf("unknown kernel '%s'.\n", optarg);
+                    }
+                    return EXIT_FAILURE;
+                }
+                opts->kernel = optarg;
+                break;
             case 'h': /* help */
                 if (proc_id == 0) {
                     print_usage(argv);
@@ -175,295 +543,5042 @@ static int parse_args(int argc, char **argv, mo_opts_t *opts, int proc_id, int p
         }
     }
     
-    /* validate blocksize */
-    if (opts->height % opts->blocksize != 0) {
-        if (proc_id == 0) {
-            print_usage(argv);
-            eprintf("argument of '-b' has to be a divisor of %d.\n", opts->height);
+    opts->formula = MO_FORMULA(opts->power, opts->burning_ship);
+
+    /* the cardioid and bulb are those of the mandelbrot set */
+    if (opts->formula != MO_FORMULA(MO_POWER, 0) || opts->julia) {
+        opts->cardioid = 0;
+    }
+
+    /* frames of a sequence are written by the master, one file each */
+    if (keyframes != NULL) {
+        if (read_keyframes(keyframes, proc_id, opts) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(opts->filename, MO_FILENAME) == 0) {
+            opts->filename = MO_FRAMENAME;
+        } else if (!frame_format(opts->filename)) {
+            if (proc_id == 0) {
+                print_usage(argv);
+                eprintf("argument of '-o' has to contain the frame number format " \
+                    "(e.g. '%%05d') as its only conversion for sequences.\n");
+            }
+            return EXIT_FAILURE;
         }
+    } else {
+        opts->frame_count = 1;
+    }
+
+    if (check_features(argv, proc_id, opts) != EXIT_SUCCESS) {
         return EXIT_FAILURE;
     }
 
-    /* prevent too large blocksizes which will break the block distribution */
-    if (opts->blocksize > opts->height/(proc_count - 1)) {
+    /* cache entries are square tiles of a fixed size, so they can be found again 
+     * in other views */
+    if (opts->cache_dir != NULL) {
+        if (mkdir(opts->cache_dir, 0755) != 0 && errno != EEXIST) {
+            if (proc_id == 0) {
+                eprintf("unable to create cache directory '%s'.\n", opts->cache_dir);
+            }
+            return EXIT_FAILURE;
+        }
+
+        opts->block_width = MO_CACHETILE;
+        opts->blocksize = MO_CACHETILE;
+        opts->schedule = MO_SCHED_FIXED;
+    }
+
+    /* blocks are the tiles of the full resolution of the pyramid */
+    if (opts->tiles != NULL) {
+        /* levels are halved down to a single pixel */
+        int size = (opts->width > opts->height) ? opts->width : opts->height;
+
+        for (opts->tile_levels = 1; size > 1; size = (size + 1)/2) ++opts->tile_levels;
+
+        opts->block_width = MO_TILESIZE;
+        opts->blocksize = MO_TILESIZE;
+        opts->schedule = MO_SCHED_FIXED;
+    }
+
+    /* the static schedule hands out whole rows once */
+    if (opts->schedule == MO_SCHED_STATIC) {
+        opts->block_width = opts->width;
+    }
+
+    /* without a master, all processes compute and write their blocks themselves */
+    if (opts->rma) {
+        opts->mpi_io = 1;
+    } else if (proc_count < 2) {
         if (proc_id == 0) {
-            print_usage(argv);
-            eprintf("argument of '-b' has to be smaller than %d.\n", opts->height/(proc_count-1));
+            eprintf("Number of processes must be at least 2.\n");
         }
         return EXIT_FAILURE;
     }
+
+    /* the master schedules chunks for the node leaders instead of its slaves */
+    if (opts->hierarchical && init_hierarchy(proc_id, opts) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    if (opts->rma) {
+        opts->workers = proc_count;
+    } else {
+        opts->workers = (opts->node_count > 0) ? opts->node_count : proc_count - 1;
+    }
+
+    /* a resumed render continues the schedule of the checkpoint, which may have 
+     * been planned for a different number of processes */
+    if (opts->resume && read_checkpoint(proc_id, opts) != EXIT_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    /* the render server sizes the blocks for each batch of requests */
+    if (opts->serve == NULL) {
+        init_blocks(opts);
+    }
     
+#ifndef _OPENMP
+    /* without OpenMP support each slave runs single threaded */
+    opts->threads = 1;
+#endif
+
+    /* events are only recorded if a trace is requested */
+    if (trace != NULL) {
+        if ((opts->trace = (mo_trace_t *) calloc(1, sizeof(*opts->trace))) == NULL) {
+            eprintf("unable to allocate memory for trace.\n");
+            return EXIT_FAILURE;
+        }
+        opts->trace->filename = trace;
+    }
+
+    /* events are only timed if they are reported */
+    opts->instrument = (opts->stats_file != NULL || opts->trace != NULL);
+
+    /* iteration counts are sent in the narrowest type that holds them */
+    opts->iteration_size = (opts->max_iterations <= 0xffff) ? 2 : 4;
+
+    for (int i = 0; i < opts->keyframe_count; ++i) {
+        if (opts->keyframes[i].max_iterations > 0xffff) opts->iteration_size = 4;
+    }
+
     /* calculate problem space */
+    opts->axis_length = axis_length;
     opts->min_re = x_offset - axis_length;
     opts->max_re = x_offset + axis_length;
     opts->min_im = y_offset - axis_length;
     opts->max_im = y_offset + axis_length;
+    opts->min_re_long = strtold(opts->x_str, NULL) - axis_length;
+    opts->min_im_long = strtold(opts->y_str, NULL) - axis_length;
 
-    /* summarize used options on master before starting computation */
-    if (proc_id == 0) {
+    opts->select_precision = (opts->precision == MO_PREC_AUTO);
+
+    /* the view of a sequence starts at the first frame */
+    if (opts->keyframes != NULL) {
+        set_frame(0, opts);
+    }
+
+    /* zooms too deep for long double are rendered by perturbation, which only
+     * exists for the mandelbrot set */
+    if (!opts->deep && opts->precision == MO_PREC_AUTO) {
+        opts->precision = auto_precision(opts);
+
+        if (opts->precision == MO_PREC_AUTO) {
+            opts->deep = (opts->formula == MO_FORMULA(MO_POWER, 0) && !opts->julia);
+
+            if (!opts->deep) opts->precision = MO_PREC_LONG;
+        }
+    }
+
+    /* the cache stores the final z of the scalar double kernel, so views have
+     * to be resolved by doubles. the view is moved by less than a pixel onto the 
+     * lattice of pixels of its zoom level, tiles of panned views line up */
+    if (opts->cache_dir != NULL) {
+        const int precision = auto_precision(opts);
+
+        if (opts->deep || precision == MO_PREC_LONG || precision == MO_PREC_AUTO) {
+            if (proc_id == 0) {
+                print_usage(argv);
+                eprintf("'--cache' requires views which can be computed in double " \
+                    "precision.\n");
+            }
+            return EXIT_FAILURE;
+        }
+
+        const double spacing_re = 2*axis_length / (double) opts->width;
+        const double spacing_im = 2*axis_length / (double) opts->height;
+        const int64_t bottom = llround(opts->min_im / spacing_im);
+
+        opts->precision = MO_PREC_DOUBLE;
+        opts->lattice_col = llround(opts->min_re / spacing_re);
+        opts->lattice_row = -(bottom + opts->height - 1);
+        opts->min_re = opts->lattice_col*spacing_re;
+        opts->max_re = opts->min_re + 2*axis_length;
+        opts->min_im = bottom*spacing_im;
+        opts->max_im = opts->min_im + 2*axis_length;
+    }
+
+    /* perturbation works on doubles. perturbed orbits can neither be checked 
+     * against the cardioid nor for exact cycles */
+    if (opts->deep) {
+        opts->precision = MO_PREC_DOUBLE;
+        opts->cardioid = 0;
+        opts->periodicity = 0;
+    }
+
+    init_symmetry(opts);
+
+    /* summarize used options on master before starting computation. the render 
+     * server does so once it is up, stdout may be its reply channel */
+    if (proc_id == 0 && opts->serve == NULL) {
         if (argc < 2) {
             printf("Note: Program invoked with default options.\n" \
                 "      Run '%s -h' for detailed information on available arguments.\n\n", argv[0]);
         }
-        print_params(opts, x_offset, y_offset, axis_length);
+        print_params(opts);
     }
 
     return EXIT_SUCCESS;
 }
 
 /*
- * display parameters used for computation
+ * check the combination of the requested features against `rules`. the 
+ * first broken rule is reported
  */
-static void print_params(mo_opts_t *opts, double x_off, double y_off, double axis_length)
+static int check_features(char **argv, int proc_id, mo_opts_t *opts)
 {
-    printf("Computation parameters:\n" \
-        "    output file              %s\n" \
-        "    maximum iterations       %d\n" \
-        "    blocksize                %d\n" \
-        "    image width              %d\n" \
-        "    image height             %d\n" \
-        "    minimum color            0x%06lx\n" \
-        "    maximum color            0x%06lx\n" \
-        "    color mask               0x%06lx\n" \
-        "    x-offset                 %g\n" \
-        "    y-offset                 %g\n" \
-        "    axis length              %g\n" \
-        "    coordinate system range  [%g, %g]\n\n",
-        opts->filename, opts->max_iterations, opts->blocksize, opts->width, opts->height, 
-        opts->min_color, opts->max_color, opts->color_mask, x_off, y_off, axis_length, 
-        opts->min_re, opts->max_re);
+    const int features = active_features(opts);
+    const mo_rule_t *rule;
+
+    for (rule = rules; rule < rules + sizeof(rules)/sizeof(*rules); ++rule) {
+        if (rule->message == NULL || !(features & rule->feature)) continue;
+
+        if ((features & rule->excludes) || (features & rule->requires) != rule->requires) {
+            if (proc_id == 0) {
+                print_usage(argv);
+                eprintf("%s\n", rule->message);
+            }
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
 }
 
 /*
- * display usage 
+ * 1 if a feature can be combined with the other active features
  */
-static void print_usage(char **argv) 
+static int supported(int feature, mo_opts_t *opts)
 {
-    printf("\nDynamic MPI mandelbrot algorithm\n\n" \
-        "usage: %s [options]\n\n" \
-        "OPTIONS:\n" \
-        "    -h                   Shows this help.\n" \
-        "    -c {width}           Width of resulting image. Has to be positive integer.\n" \
-        "                         (default: %d)\n" \
-        "    -r {height}          Height of resulting image. Has to be positive integer.\n" \
-        "                         (default: %d)\n" \
-        "    -n {iterations}      Maximum number of iterations for each pixel. Has to be\n" \
-        "                         positive integer (default: %d)\n" \
-        "    -o {filename}        Filename of resulting bitmap. (default: %s)\n" \
-        "    -b {blocksize}       Number of rows to be assigned to a slave at once.\n" \
-        "                         Has to be smaller than (height/slave-count).\n" \
-        "                         Has to be a divisor of height. (default: %d)\n" \
-        "    -x {offset}          X-offset from [0,0]. (default: %g)\n" \
-        "    -y {offset}          Y-offset from [0,0]. (default: %g)\n" \
-        "    -a {length}          Absolute value range of x/y-axis, e.g. if length was 2, \n" \
-        "                         displayed x/y-values would range from -1 to 1. \n" \
-        "                         If the x/y-offsets are set, axis shifts by those offsets.\n" \
-        "                         Negative value inverts axis.\n" \
-        "                         Has to be non-zero double value. (default: %g)\n" \
-        "    -p {hexnum}          Minimum color of the resulting image. (default: 0x%06lx)\n" \
-        "    -q {hexnum}          Maximum color of the resulting image. (default: 0x%06lx)\n" \
-        "    -m {hexnum}          Hex mask to manipulate color ranges. (default: 0x%06lx)\n" \
-        "    -s                   Print progress of the computation.\n\n",
-        argv[0], MO_SIZE, MO_SIZE, MO_MAXITER, MO_FILENAME, MO_BLOCKSIZE, 0.0f, 0.0f, 
-        (double) MO_N, (long) MO_COLORMIN, (long) MO_COLORMAX, (long) MO_COLORMASK);
+    const int features = active_features(opts);
+    const mo_rule_t *rule;
+
+    for (rule = rules; rule < rules + sizeof(rules)/sizeof(*rules); ++rule) {
+        if (rule->feature == feature && ((features & rule->excludes) || 
+                (features & rule->requires) != rule->requires)) {
+            return 0;
+        }
+    }
+
+    return 1;
 }
 
 /*
- * master process logic
+ * features requested by opts (MO_FEAT_*). the cache and the tiles choose a 
+ * schedule of their own
  */
-static int master_proc(int slave_count, mo_opts_t *opts) 
+static int active_features(mo_opts_t *opts)
 {
-    int *rows = (int *) malloc(opts->blocksize*sizeof(*rows));
-    long *data = (long *) malloc((opts->width + 1)*opts->blocksize*sizeof(*data));
-    char *rgb = (char *) malloc(3*opts->width*opts->height*sizeof(*rgb));
+    int features = 0;
 
-    if (rows == NULL || data == NULL || rgb == NULL) {
-        eprintf("unable to allocate memory for buffers.\n");
-        free(rows); free(data); free(rgb);
-        return EXIT_FAILURE;
-    }
-    
-    int proc_id, offset; 
-    double start_time, end_time;
-    long pixel_color, pixel_pos;
-    int current_row = 0;
-    int running_tasks = 0;
-    int retval = EXIT_SUCCESS; 
-    
-    MPI_Status status;
+    if (opts->formula != MO_FORMULA(MO_POWER, 0) || opts->julia) features |= MO_FEAT_FORMULA;
+    if (opts->deep) features |= MO_FEAT_DEEP;
+    if (opts->cache_dir != NULL) features |= MO_FEAT_CACHE;
+    if (opts->keyframes != NULL) features |= MO_FEAT_KEYFRAMES;
+    if (opts->mpi_io) features |= MO_FEAT_MPIIO;
+    if (opts->rma) features |= MO_FEAT_RMA;
+    if (opts->serve != NULL) features |= MO_FEAT_SERVE;
+    if (opts->checkpoint != NULL) features |= MO_FEAT_CHECKPOINT;
+    if (opts->resume) features |= MO_FEAT_RESUME;
+    if (opts->tiles != NULL) features |= MO_FEAT_TILES;
+    if (opts->mode == MO_MODE_PROGRESSIVE) features |= MO_FEAT_PROGRESSIVE;
+    if (opts->hierarchical) features |= MO_FEAT_HIERARCHICAL;
+    if (opts->compress) features |= MO_FEAT_COMPRESS;
+    if (opts->antialias > 1) features |= MO_FEAT_ANTIALIAS;
+    if (opts->symmetry) features |= MO_FEAT_SYMMETRY;
 
-    printf("Computation started.\n");
-    
-    /* get start time */
-    start_time = MPI_Wtime();
-    
-    /* assign each slave initial row(s) */
-    for (int p = 0; p < slave_count; ++p) {
-        for (int i = 0; i < opts->blocksize; ++i) {
-            rows[i] = current_row++;
-        }
-        MPI_Send(rows, opts->blocksize, MPI_INT, p + 1, MO_CALC, MPI_COMM_WORLD);
-        ++running_tasks;
+    if (opts->schedule == MO_SCHED_FIXED) features |= MO_FEAT_FIXED;
+
+    if (opts->schedule == MO_SCHED_STATIC && opts->cache_dir == NULL) {
+        features |= MO_FEAT_STATIC;
     }
 
-    /* reveice results from slaves until all rows are processed */
-    while (running_tasks > 0) {
-        MPI_Recv(data, (opts->width + 1)*opts->blocksize, MPI_LONG, MPI_ANY_SOURCE,
-                MO_DATA, MPI_COMM_WORLD, &status);
+    return features;
+}
 
-        --running_tasks;
-        proc_id = status.MPI_SOURCE;
+/*
+ * read keyframes of a sequence from file on process 0 and broadcast them to
+ * all processes. lines are "x-offset y-offset axis-length iterations", empty
+ * lines and lines starting with '#' are skipped
+ */
+static int read_keyframes(const char *filename, int proc_id, mo_opts_t *opts)
+{
+    char *buffer = NULL, *line, *state;
+    long length = -1;
+    mo_keyframe_t *keyframe;
+    FILE *file;
 
-        /* if there are still rows to be processed, send slave to work again
-         * otherwise send him to sleep */
-        if (current_row < opts->height) {
-            for (int i = 0; i < opts->blocksize; ++i) {
-                rows[i] = current_row++;
-            }
-            MPI_Send(rows, opts->blocksize, MPI_INT, proc_id, MO_CALC, MPI_COMM_WORLD);
-            ++running_tasks;
+    if (proc_id == 0) {
+        if ((file = fopen(filename, "r")) == NULL) {
+            eprintf("unable to open keyframes file '%s'.\n", filename);
         } else {
-            MPI_Send(NULL, 0, MPI_INT, proc_id, MO_STOP, MPI_COMM_WORLD);
-        }
-
-        /* store received row(s) in rgb buffer */
-        for (int i = 0; i < opts->blocksize; ++i) {
-            offset = opts->width*i;
-
-            for (int col = 0; col < opts->width; ++col) {
-                pixel_color = data[offset + col + 1] & opts->color_mask;
-                pixel_pos = 3*(opts->width*data[offset] + col);
+            if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 &&
+                    fseek(file, 0, SEEK_SET) == 0 && 
+                    (buffer = (char *) malloc(length + 1)) != NULL &&
+                    fread(buffer, 1, length, file) != (size_t) length) {
+                length = -1;
+            }
 
-                rgb[pixel_pos] = (char) ((pixel_color >> 16) & 0xFF);
-                rgb[pixel_pos + 1] = (char) ((pixel_color >> 8) & 0xFF);
-                rgb[pixel_pos + 2] = (char) (pixel_color & 0xFF);
+            if (length == -1 || buffer == NULL) {
+                eprintf("unable to read keyframes file '%s'.\n", filename);
+                length = -1;
             }
-        }
 
-        /* only show progress if option set */
-        if (opts->show_progress) {
-            static int rows_processed = 0;
-            print_progress(rows_processed += opts->blocksize, opts->height);
+            fclose(file);
         }
     }
 
-    /* get end time  */
-    end_time = MPI_Wtime();
+    MPI_Bcast(&length, 1, MPI_LONG, 0, MPI_COMM_WORLD);
 
-    /* clear progress bar from stdout */
-    if (opts->show_progress) printf("\033[K");
+    if (length == -1) {
+        free(buffer);
+        return EXIT_FAILURE;
+    }
+
+    if (proc_id != 0 && (buffer = (char *) malloc(length + 1)) == NULL) {
+        eprintf("unable to allocate memory for keyframes.\n");
+        finalize_exit(EXIT_FAILURE);
+    }
+
+    MPI_Bcast(buffer, length, MPI_CHAR, 0, MPI_COMM_WORLD);
+    buffer[length] = '\0';
+
+    /* there are at most as many keyframes as lines */
+    opts->keyframe_count = 1;
+
+    for (long i = 0; i < length; ++i) {
+        if (buffer[i] == '\n') ++opts->keyframe_count;
+    }
+
+    opts->keyframes = (mo_keyframe_t *) malloc(opts->keyframe_count*sizeof(*opts->keyframes));
+    opts->keyframe_count = 0;
+
+    if (opts->keyframes == NULL) {
+        eprintf("unable to allocate memory for keyframes.\n");
+        free(buffer);
+        return EXIT_FAILURE;
+    }
+
+    for (line = strtok_r(buffer, "\n", &state); line != NULL; 
+            line = strtok_r(NULL, "\n", &state)) {
+        line += strspn(line, " \t\r");
+
+        if (*line == '\0' || *line == '#') continue;
+
+        keyframe = opts->keyframes + opts->keyframe_count;
+
+        if (sscanf(line, "%Lf %Lf %lf %d", &keyframe->x, &keyframe->y, 
+                &keyframe->axis_length, &keyframe->max_iterations) != 4 ||
+                keyframe->axis_length == 0 || keyframe->max_iterations <= 0) {
+            if (proc_id == 0) {
+                eprintf("invalid keyframe '%s' in '%s'.\n", line, filename);
+            }
+            free(buffer);
+            return EXIT_FAILURE;
+        }
+
+        ++opts->keyframe_count;
+    }
+
+    free(buffer);
+
+    if (opts->keyframe_count == 0) {
+        if (proc_id == 0) {
+            eprintf("no keyframes in '%s'.\n", filename);
+        }
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * fit the blocks into the image and size the buffers for the first band of 
+ * blocks, which is the largest one
+ */
+static void init_blocks(mo_opts_t *opts)
+{
+    if (opts->block_width == 0 || opts->block_width > opts->width) {
+        opts->block_width = opts->width;
+    }
+
+    if (opts->blocksize > opts->height) {
+        opts->blocksize = opts->height;
+    }
+
+    opts->max_rows = band_rows((int64_t) opts->frame_count*opts->height, opts->workers, opts);
+
+    if (opts->max_rows > opts->height) opts->max_rows = opts->height;
+}
+
+/*
+ * the mandelbrot and multibrot sets and julia sets of real constants are 
+ * symmetric to the real axis, the burning ship is not. if the view spans it 
+ * and the axis lies on a row or halfway between two rows, the rows on both 
+ * sides of it are pairs of mirror images. the rows below the axis whose 
+ * mirror image is in the view are not computed, the master writes the colors
+ * of their mirror rows to them. the view needs to be the same for all blocks 
+ * and their rows have to pass through the master, so other modes compute all 
+ * rows
+ */
+static void init_symmetry(mo_opts_t *opts)
+{
+    const double spacing = (opts->max_im - opts->min_im) / (double) opts->height;
+
+    /* row r lies at min_im + (height - 1 - r)*spacing, so the mirror image of 
+     * row r is row `sum - r`. it is on the lattice if sum is an integer */
+    const double sum = 2*(opts->height - 1) + 2*opts->min_im/spacing;
+
+    opts->mirror = 0;
+    opts->mirrored = NULL;
+
+    if (!opts->symmetry || !supported(MO_FEAT_SYMMETRY, opts) || opts->burning_ship || 
+            (opts->julia && opts->julia_im != 0)) {
+        return;
+    }
+
+    /* at least one pair of rows has to be in the view */
+    if (sum < 0.5 || sum > 2*opts->height - 2.5 || fabs(sum - nearbyint(sum)) > MO_MIRRORTOL) {
+        return;
+    }
+
+    /* without memory for the counts all rows are computed */
+    if ((opts->mirrored = (int *) malloc((opts->height + 1)*sizeof(int))) == NULL) {
+        return;
+    }
+
+    mo_opts_t sub;
+    mo_scale_t scale, sub_scale;
+
+    opts->mirror = (int) nearbyint(sum);
+    opts->mirrored[0] = 0;
+
+    init_scale(&scale, opts);
+    init_samples(&sub, &sub_scale, opts);
+
+    for (int row = 0; row < opts->height; ++row) {
+        const int source = opts->mirror - row;
+        int mirrored = (row > source && source >= 0 && 
+                mirror_exact(row, &scale, &sub_scale, &sub, opts));
+
+        /* anti-aliasing compares a pixel with its neighbors, which have to be 
+         * mirror images of those of the source as well */
+        for (int d = -1; d <= 1 && mirrored && opts->antialias > 1; d += 2) {
+            const int inside = (row + d >= 0 && row + d < opts->height);
+
+            if (inside != (source - d >= 0 && source - d < opts->height) || 
+                    (inside && !mirror_exact(row + d, &scale, &sub_scale, &sub, opts))) {
+                mirrored = 0;
+            }
+        }
+
+        opts->mirrored[row + 1] = opts->mirrored[row] + mirrored;
+    }
+
+    if (opts->mirrored[opts->height] == 0) {
+        free(opts->mirrored);
+        opts->mirrored = NULL;
+        opts->mirror = 0;
+    }
+}
+
+/*
+ * 1 if the pixels of a row lie exactly at the negated imaginary part of those 
+ * of its mirror row in the precision of the kernels, as do the samples of the
+ * pixels if anti-aliasing is enabled. the rows are images of each other 
+ * otherwise, but their colors may differ by rounding
+ */
+static int mirror_exact(int row, mo_scale_t *scale, mo_scale_t *sub_scale, mo_opts_t *sub, 
+        mo_opts_t *opts)
+{
+    const int n = opts->antialias, source = opts->mirror - row;
+
+    if (row_im(row, scale, opts) != -row_im(source, scale, opts)) return 0;
+
+    for (int y = 0; y < n && n > 1; ++y) {
+        if (row_im(n*row + y, sub_scale, sub) != -row_im(n*source + n - 1 - y, sub_scale, sub)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * imaginary part of the pixels of a row as computed by the kernels of the 
+ * precision of the render
+ */
+static long double row_im(int row, mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int index = opts->height - 1 - row;
+    double im;
+
+    if (opts->precision == MO_PREC_LONG) {
+        return opts->min_im_long + (long double) index*scale->im_long;
+    }
+
+    im = opts->min_im + (double) index*scale->im;
+
+    return (opts->precision == MO_PREC_FLOAT) ? (float) im : im;
+}
+
+/*
+ * 1 if the colors of a row are copied from its mirror row
+ */
+static inline int is_mirrored(int row, mo_opts_t *opts)
+{
+    return opts->mirrored != NULL && row >= 0 && row < opts->height && 
+        opts->mirrored[row + 1] > opts->mirrored[row];
+}
+
+/*
+ * group the processes by node for the hierarchical schedule. the lowest rank 
+ * of each node besides the master leads it: it talks to the master on the 
+ * communicator of the leaders and to the workers of its node on the node's 
+ * communicator, on which workers talk to their leader only
+ */
+static int init_hierarchy(int proc_id, mo_opts_t *opts)
+{
+    MPI_Comm shared, leaders;
+    int is_leader = 0, node_size = INT_MAX, rank;
+
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, proc_id, MPI_INFO_NULL, &shared);
+    MPI_Comm_split(shared, (proc_id == 0) ? MPI_UNDEFINED : 0, proc_id, &opts->node_comm);
+    MPI_Comm_free(&shared);
+
+    if (opts->node_comm != MPI_COMM_NULL) {
+        MPI_Comm_rank(opts->node_comm, &rank);
+        MPI_Comm_size(opts->node_comm, &node_size);
+        is_leader = (rank == 0);
+    }
+
+    MPI_Comm_split(MPI_COMM_WORLD, (proc_id == 0 || is_leader) ? 0 : MPI_UNDEFINED, proc_id, 
+            &leaders);
+    MPI_Allreduce(&is_leader, &opts->node_count, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &node_size, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+    opts->comm = (proc_id == 0 || is_leader) ? leaders : opts->node_comm;
+
+    /* a leader doesn't compute, so it needs at least one worker */
+    if (node_size < 2) {
+        if (proc_id == 0) {
+            eprintf("'--hierarchical' requires at least two processes on each node " \
+                "besides the master.\n");
+        }
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * switch the view to frame `frame` of the sequence, which is interpolated
+ * between the keyframes: the axis length geometrically, so the zoom speed is
+ * constant, the center such that the point the zoom heads for stays in place,
+ * and the iterations linearly
+ */
+static void set_frame(int frame, mo_opts_t *opts)
+{
+    const int last = opts->keyframe_count - 1;
+    double t = (opts->frame_count > 1) ? (double) frame*last/(opts->frame_count - 1) : 0;
+    int i = (t < last) ? (int) t : last;
+    const mo_keyframe_t *from = opts->keyframes + i;
+    const mo_keyframe_t *to = opts->keyframes + ((i < last) ? i + 1 : i);
+    double u = t - i;
+    double axis_length = from->axis_length*pow(fabs(to->axis_length/from->axis_length), u);
+    double w = (to->axis_length != from->axis_length) 
+        ? (from->axis_length - axis_length)/(from->axis_length - to->axis_length) 
+        : u;
+    long double x = from->x + (to->x - from->x)*w;
+    long double y = from->y + (to->y - from->y)*w;
+
+    opts->max_iterations = (int) (from->max_iterations + 
+        (to->max_iterations - from->max_iterations)*u + 0.5);
+
+    opts->axis_length = axis_length;
+    opts->min_re = (double) x - axis_length;
+    opts->max_re = (double) x + axis_length;
+    opts->min_im = (double) y - axis_length;
+    opts->max_im = (double) y + axis_length;
+    opts->min_re_long = x - axis_length;
+    opts->min_im_long = y - axis_length;
+
+    /* requests of the render server have colors of their own */
+    if (opts->requests != NULL) {
+        opts->min_color = opts->requests[frame].min_color;
+        opts->max_color = opts->requests[frame].max_color;
+    }
+
+    /* sequences are not rendered by perturbation, long double is the limit */
+    if (opts->select_precision) {
+        opts->precision = auto_precision(opts);
+
+        if (opts->precision == MO_PREC_AUTO) opts->precision = MO_PREC_LONG;
+    }
+}
+
+/*
+ * 1 if a filename is a format for the frame number: it contains exactly one 
+ * conversion, of an int with optional flags and width, besides '%%'. the 
+ * filename is passed to snprintf as format, so nothing else is accepted
+ */
+static int frame_format(const char *filename)
+{
+    int conversions = 0;
+
+    for (const char *c = filename; *c != '\0'; ++c) {
+        if (*c != '%') continue;
+
+        if (*++c == '%') continue;
+
+        c += strspn(c, "-+ #0");
+
+        /* widths beyond the length of paths are of no use */
+        if (strspn(c, "0123456789") > 3) return 0;
+
+        c += strspn(c, "0123456789");
+
+        if (*c != 'd' && *c != 'i' && *c != 'u') return 0;
+
+        ++conversions;
+    }
+
+    return conversions == 1;
+}
+
+/*
+ * name of the file of frame `frame`, which is written to buffer (of 
+ * MO_PATHLEN bytes). filenames of sequences were checked by frame_format()
+ */
+static void frame_filename(char *buffer, int frame, mo_opts_t *opts)
+{
+    if (opts->requests != NULL) {
+        snprintf(buffer, MO_PATHLEN, "%s", opts->requests[frame].filename);
+    } else if (opts->keyframes != NULL) {
+        snprintf(buffer, MO_PATHLEN, opts->filename, frame);
+    } else {
+        snprintf(buffer, MO_PATHLEN, "%s", opts->filename);
+    }
+}
+
+/*
+ * select the cheapest precision which resolves the pixel spacing at the 
+ * largest coordinate of the region with MO_PRECMARGIN bits to spare. returns
+ * MO_PREC_AUTO if none does. float is never selected: orbits near the 
+ * boundary diverge after a different number of iterations in float than in 
+ * double at any pixel spacing, so it is only used if requested
+ */
+static int auto_precision(mo_opts_t *opts)
+{
+    const int size = (opts->width > opts->height) ? opts->width : opts->height;
+    double spacing = fabs(2*opts->axis_length)/size;
+    double magnitude = fabs(opts->min_re);
+
+    if (fabs(opts->max_re) > magnitude) magnitude = fabs(opts->max_re);
+    if (fabs(opts->min_im) > magnitude) magnitude = fabs(opts->min_im);
+    if (fabs(opts->max_im) > magnitude) magnitude = fabs(opts->max_im);
+
+    if (spacing >= ldexp(magnitude, MO_PRECMARGIN - DBL_MANT_DIG)) {
+        return MO_PREC_DOUBLE;
+    }
+
+    if (spacing >= ldexp(magnitude, MO_PRECMARGIN - LDBL_MANT_DIG)) {
+        return MO_PREC_LONG;
+    }
+
+    return MO_PREC_AUTO;
+}
+
+/*
+ * display parameters used for computation
+ */
+static void print_params(mo_opts_t *opts)
+{
+    char antialias[48] = "off";
+    char tiles[MO_PATHLEN + 64] = "off";
+    char symmetry[48] = "off";
+    char scheduling[48] = "master";
+    char fractal[96];
+
+    snprintf(fractal, sizeof(fractal), "%s, z^%d + c", opts->burning_ship 
+            ? (opts->julia ? "burning ship julia set" : "burning ship") 
+            : (opts->julia ? "julia set" : ((opts->power > 2) ? "multibrot set" : "mandelbrot set")), 
+            opts->power);
+
+    if (opts->julia) {
+        snprintf(fractal + strlen(fractal), sizeof(fractal) - strlen(fractal), 
+                ", c = %Lg%+Lgi", opts->julia_re, opts->julia_im);
+    }
+
+    if (opts->antialias > 1) {
+        snprintf(antialias, sizeof(antialias), "%dx%d samples of edges", opts->antialias, 
+                opts->antialias);
+    }
+
+    if (opts->rma) {
+        snprintf(scheduling, sizeof(scheduling), "shared counter (RMA)");
+    } else if (opts->node_count > 0) {
+        snprintf(scheduling, sizeof(scheduling), "master and %d node leader%s", 
+                opts->node_count, (opts->node_count > 1) ? "s" : "");
+    }
+
+    if (opts->mirror > 0) {
+        snprintf(symmetry, sizeof(symmetry), "%d rows mirrored", 
+                opts->mirrored[opts->height]);
+    }
+
+    if (opts->tiles != NULL) {
+        snprintf(tiles, sizeof(tiles), "%.*s.dzi, %d levels of %dx%d tiles", MO_PATHLEN, 
+                opts->tiles, opts->tile_levels, MO_TILESIZE, MO_TILESIZE);
+    }
+
+    printf("Computation parameters:\n" \
+        "    output file              %s\n" \
+        "    frames                   %d\n" \
+        "    fractal                  %s\n" \
+        "    maximum iterations       %d\n" \
+        "    blocksize                %d\n" \
+        "    block width              %d\n" \
+        "    block size schedule      %s\n" \
+        "    image width              %d\n" \
+        "    image height             %d\n" \
+        "    minimum color            0x%06lx\n" \
+        "    maximum color            0x%06lx\n" \
+        "    color mask               0x%06lx\n" \
+        "    x-offset                 %s\n" \
+        "    y-offset                 %s\n" \
+        "    axis length              %g\n" \
+        "    coordinate system range  [%g, %g]\n" \
+        "    kernel                   %s\n" \
+        "    precision                %s\n" \
+        "    threads per slave        %d\n" \
+        "    blocks queued per slave  %d\n" \
+        "    result encoding          %d bit%s\n" \
+        "    cardioid/bulb check      %s\n" \
+        "    periodicity check        %s\n" \
+        "    real axis symmetry       %s\n" \
+        "    render mode              %s\n" \
+        "    anti-aliasing            %s\n" \
+        "    block scheduling         %s\n" \
+        "    output written by        %s\n" \
+        "    tile cache               %s\n" \
+        "    tile pyramid             %s\n" \
+        "    render server            %s\n" \
+        "    checkpoint               %s%s\n\n",
+        opts->filename, opts->frame_count, fractal, opts->max_iterations, opts->blocksize, opts->block_width, 
+        schedules[opts->schedule], opts->width, opts->height, 
+        opts->min_color, opts->max_color, opts->color_mask, opts->x_str, opts->y_str, 
+        opts->axis_length, 
+        opts->min_re, opts->max_re, 
+        (opts->cache_dir != NULL) ? "scalar" : pixel_kernel(opts)->name, 
+        (opts->precision == MO_PREC_LONG) ? "long double" : precisions[opts->precision], 
+        opts->threads, opts->depth, 8*opts->iteration_size, 
+        opts->compress ? ", run-length encoded" : "", opts->cardioid ? "on" : "off", 
+        opts->periodicity ? "on" : "off", symmetry, modes[opts->mode], antialias, 
+        scheduling, 
+        opts->rma ? "all processes (MPI-IO)" : (opts->mpi_io ? "slaves (MPI-IO)" : 
+            ((opts->tiles != NULL) ? "slaves (tiles)" : "master")),
+        (opts->cache_dir != NULL) ? opts->cache_dir : "off", tiles, 
+        (opts->serve == NULL) ? "off" : ((strcmp(opts->serve, "-") == 0) ? "stdin" : opts->serve), 
+        (opts->checkpoint != NULL) ? opts->checkpoint : "off", 
+        opts->resume ? " (resumed)" : "");
+}
+
+/*
+ * display usage 
+ */
+static void print_usage(char **argv) 
+{
+    printf("\nDynamic MPI mandelbrot algorithm\n\n" \
+        "usage: %s [options]\n\n" \
+        "OPTIONS:\n" \
+        "    -h                   Shows this help.\n" \
+        "    -c {width}           Width of resulting image. Has to be positive integer.\n" \
+        "                         (default: %d)\n" \
+        "    -r {height}          Height of resulting image. Has to be positive integer.\n" \
+        "                         (default: %d)\n" \
+        "    -n {iterations}      Maximum number of iterations for each pixel. Has to be\n" \
+        "                         positive integer (default: %d)\n" \
+        "    -o {filename}        Filename of resulting bitmap. (default: %s)\n" \
+        "    -b {blocksize}       Minimum number of rows to be assigned to a slave at\n" \
+        "                         once. Has to be positive integer. (default: %d)\n" \
+        "    -w {width}           Number of columns to be assigned to a slave at once,\n" \
+        "                         so blocks are tiles instead of whole rows. Has to be\n" \
+        "                         positive integer. (default: image width)\n" \
+        "    -x {offset}          X-offset from [0,0]. (default: %g)\n" \
+        "    -y {offset}          Y-offset from [0,0]. (default: %g)\n" \
+        "    -a {length}          Absolute value range of x/y-axis, e.g. if length was 2, \n" \
+        "                         displayed x/y-values would range from -1 to 1. \n" \
+        "                         If the x/y-offsets are set, axis shifts by those offsets.\n" \
+        "                         Negative value inverts axis.\n" \
+        "                         Has to be non-zero double value. (default: %g)\n" \
+        "    -p {hexnum}          Minimum color of the resulting image. (default: 0x%06lx)\n" \
+        "    -q {hexnum}          Maximum color of the resulting image. (default: 0x%06lx)\n" \
+        "    -m {hexnum}          Hex mask to manipulate color ranges. (default: 0x%06lx)\n" \
+        "    -s                   Print progress of the computation.\n" \
+        "    -k {kernel}          Row kernel: auto, avx512, avx2, sse2 or scalar. Falls\n" \
+        "                         back to the next supported one if the cpu lacks the\n" \
+        "                         instruction set. (default: %s)\n" \
+        "    -t {threads}         Number of threads each slave splits its rows across, \n" \
+        "                         e.g. run one slave per node with one thread per core.\n" \
+        "                         Has to be positive integer. (default: %d)\n" \
+        "    -d {depth}           Number of blocks queued per slave, so slaves don't sit\n" \
+        "                         idle waiting for the next block. Has to be positive\n" \
+        "                         integer. (default: %d)\n" \
+        "    -z                   Run-length encode results sent to the master.\n",
+        argv[0], MO_SIZE, MO_SIZE, MO_MAXITER, MO_FILENAME, MO_BLOCKSIZE, 0.0f, 0.0f, 
+        (double) MO_N, (long) MO_COLORMIN, (long) MO_COLORMAX, (long) MO_COLORMASK, MO_KERNEL, 
+        MO_THREADS, MO_DEPTH);
+
+    /* long options, split off to stay below the string length limit of C99 */
+    printf("    --no-cardioid        Don't skip points in the main cardioid or the period-2\n" \
+        "                         bulb, which are known to never diverge.\n" \
+        "    --no-periodicity     Don't stop iterating points whose orbit is caught in a\n" \
+        "                         cycle.\n" \
+        "    --no-symmetry        Compute the rows below the real axis instead of\n" \
+        "                         mirroring the rows above it. Rows are mirrored if the\n" \
+        "                         axis lies on a row or halfway between two rows, e.g.\n" \
+        "                         with a y-offset of 0. Only rows whose coordinates\n" \
+        "                         are exactly those of the rows above negated are\n" \
+        "                         mirrored, so the image doesn't change.\n" \
+        "    --power {d}          Iterate z^d + c instead of z^2 + c, which renders the\n" \
+        "                         multibrot sets. Has to be between 2 and %d.\n" \
+        "                         (default: %d)\n" \
+        "    --burning-ship       Iterate the absolute values of the real and imaginary\n" \
+        "                         part of z, which renders the burning ship fractal.\n" \
+        "    --julia {re,im}      Render the julia set of the constant c = re + im*i,\n" \
+        "                         z starts at the pixel instead of zero. Combines with\n" \
+        "                         --power and --burning-ship, which can't be combined\n" \
+        "                         with --deep or --cache.\n" \
+        "    --mode {mode}        Render mode of the slaves:\n" \
+        "                         rows     compute every pixel of a block.\n" \
+        "                         mariani  compute the border of a block only and fill\n" \
+        "                                  it if the border has a single iteration\n" \
+        "                                  count, otherwise subdivide it. Pays off\n" \
+        "                                  with large blocksizes and high iteration\n" \
+        "                                  counts, may differ from 'rows' in single\n" \
+        "                                  pixels.\n" \
+        "                         progressive\n" \
+        "                                  compute every 8th pixel of every 8th row\n" \
+        "                                  first, then every 4th and so on. Pixels\n" \
+        "                                  between pixels of the previous pass are\n" \
+        "                                  guessed if those agree. A preview is stored\n" \
+        "                                  after each pass, may differ from 'rows' in\n" \
+        "                                  single pixels. (default: rows)\n" \
+        "    --mpi-io             Slaves write their rows to the file with MPI-IO, the\n" \
+        "                         master only writes the header and schedules blocks.\n" \
+        "    --schedule {name}    Block size schedule:\n" \
+        "                         guided   start with large blocks taking half of the\n" \
+        "                                  remaining rows per round of blocks for all\n" \
+        "                                  slaves and shrink them down to blocksize\n" \
+        "                                  towards the end.\n" \
+        "                         fixed    blocks of blocksize rows.\n" \
+        "                         static   one contiguous chunk of rows per slave. The\n" \
+        "                                  chunks are balanced by the cost of the\n" \
+        "                                  rows estimated from a preview of every\n" \
+        "                                  %dth pixel with up to %d iterations.\n" \
+        "                                  (default: guided)\n" \
+        "    --rma                Run without master: all processes claim blocks from a\n" \
+        "                         shared counter with MPI one-sided operations and\n" \
+        "                         write them to the file with MPI-IO.\n" \
+        "    --hierarchical       Schedule in two levels: a leader on each node fetches\n" \
+        "                         large chunks from the master and splits them among\n" \
+        "                         the other processes of its node, which store their\n" \
+        "                         results in a shared memory window. Only whole chunks\n" \
+        "                         are sent to the master.\n",
+        MO_MAXPOWER, MO_POWER, MO_PREVIEWSTEP, MO_PREVIEWITER);
+
+    printf("    --precision {name}   Floating point precision: float, double or long (long\n" \
+        "                         double). By default double or, if it can't resolve\n" \
+        "                         the pixel spacing, long double is selected, zooms\n" \
+        "                         too deep for long double are rendered with --deep,\n" \
+        "                         those of other fractals than the mandelbrot set in\n" \
+        "                         long double. float is faster, but may differ from\n" \
+        "                         double in single pixels. (default: auto)\n" \
+        "    --keyframes {file}   Render a zoom sequence along the keyframes in file,\n" \
+        "                         one per line: x-offset y-offset axis-length\n" \
+        "                         iterations. Frames are interpolated between them\n" \
+        "                         and stored in files named by '-o', whose only\n" \
+        "                         conversion (e.g. '%%05d') is replaced by the frame\n" \
+        "                         number. (default: %s)\n" \
+        "    --frames {count}     Number of frames of the sequence. (default: 1)\n" \
+        "    --antialias {n}      Anti-alias edge pixels, whose iteration count differs\n" \
+        "                         from a neighbor by more than %g%%: their color is the\n" \
+        "                         mean of n x n samples spread evenly over the pixel.\n" \
+        "                         1 turns anti-aliasing off, at most %d. (default: %d)\n" \
+        "    --cache {dir}        Tile cache: blocks are square tiles of %d pixels on the\n" \
+        "                         pixel lattice of the zoom level, which are stored\n" \
+        "                         in dir and reused by later renders of overlapping\n" \
+        "                         views. Pixels which did not diverge continue from\n" \
+        "                         their final z if the iterations are raised. The\n" \
+        "                         view is moved by less than a pixel onto the lattice.\n" \
+        "    --tiles {name}       Write a DeepZoom tile pyramid instead of the bitmap:\n" \
+        "                         name.dzi and tiles of %d pixels in name_files/,\n" \
+        "                         one directory per level. Blocks are the tiles of\n" \
+        "                         the full resolution, which the slaves write as\n" \
+        "                         bitmaps. Tiles of coarser levels are downsampled\n" \
+        "                         by the slaves as soon as their children are done.\n" \
+        "    --serve {socket}     Keep running and render requests read from the unix\n" \
+        "                         domain socket, or from stdin if socket is '-', one\n" \
+        "                         per line: options -c, -r, -n, -x, -y, -a, -p, -q and\n" \
+        "                         -o, the others default to the command line. Each is\n" \
+        "                         answered by a line 'ok {filename} {seconds}' or\n" \
+        "                         'error ...' once done, 'quit' stops the server.\n" \
+        "                         Requests of the same size which arrive together are\n" \
+        "                         rendered like frames of one sequence, up to %d.\n",
+        MO_FRAMENAME, 100*MO_AAEDGE, MO_MAXANTIALIAS, MO_ANTIALIAS, MO_CACHETILE, MO_TILESIZE, 
+        MO_MAXBATCH);
+
+    printf("    --checkpoint {file}  Record the blocks stored in the bitmap in file, which\n" \
+        "                         is written in the background periodically.\n" \
+        "    --checkpoint-interval {seconds}\n" \
+        "                         Time between checkpoints. (default: %d)\n" \
+        "    --resume             Continue an interrupted render from its checkpoint\n" \
+        "                         and bitmap, only blocks still missing are computed.\n" \
+        "                         Requires the same options, except for the number\n" \
+        "                         of processes.\n" \
+        "    --stats {file}       Display run time statistics and append them to the\n" \
+        "                         csv file: Mpixels/s, Giterations/s, time spent on\n" \
+        "                         compute, communication, color mapping and write\n" \
+        "                         (maxima over all processes) and load imbalance.\n" \
+        "    --trace {file}       Record computation, waits, color mapping and writes\n" \
+        "                         of every block on all processes and write them to\n" \
+        "                         file in chrome's trace event format (open it in\n" \
+        "                         ui.perfetto.dev). Displays the utilization of each\n" \
+        "                         process.\n" \
+        "    --deep               Deep zoom: iterate the difference of each pixel to a\n" \
+        "                         reference orbit at the center (-x/-y), which is \n" \
+        "                         computed with arbitrary precision from the decimal\n" \
+        "                         offsets. Works for axis lengths far below 1e-13.\n\n",
+        MO_CKPTINTERVAL);
+}
+
+/*
+ * render server: process 0 reads requests and hands them to all processes in
+ * batches, which the master and slaves render like the frames of a sequence.
+ * the processes stay up until the server is stopped
+ */
+static int serve(int proc_id, int proc_count, mo_opts_t *opts)
+{
+    const int block_width = opts->block_width;
+    const int blocksize = opts->blocksize;
+    mo_request_t *requests = (mo_request_t *) malloc(MO_MAXBATCH*sizeof(*requests));
+    mo_server_t *server = (proc_id == 0) ? (mo_server_t *) malloc(sizeof(*server)) : NULL;
+    int retval = EXIT_SUCCESS;
+    int count;
+
+    opts->keyframes = (mo_keyframe_t *) malloc(MO_MAXBATCH*sizeof(*opts->keyframes));
+
+    if (server != NULL) {
+        retval = open_server(server, opts);
+    }
+
+    if (requests == NULL || opts->keyframes == NULL || (proc_id == 0 && server == NULL)) {
+        eprintf("unable to allocate memory for requests.\n");
+        retval = EXIT_FAILURE;
+    }
+
+    /* all processes give up if any of them failed */
+    MPI_Allreduce(MPI_IN_PLACE, &retval, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    if (retval == EXIT_SUCCESS && proc_id == 0) {
+        print_params(opts);
+        fflush(stdout);
+    }
+
+    opts->server = server;
+
+    while (retval == EXIT_SUCCESS) {
+        count = (proc_id == 0) ? next_batch(server, requests) : 0;
+
+        MPI_Bcast(&count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+        if (count == 0) break;
+
+        MPI_Bcast(requests, count*sizeof(*requests), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+        /* blocks are fit into the images of each batch anew */
+        opts->block_width = block_width;
+        opts->blocksize = blocksize;
+        set_batch(requests, count, opts);
+
+        if (proc_id == 0) {
+            master_proc(proc_count - 1, opts);
+
+            /* requests which were not stored failed */
+            for (int i = 0; i < count; ++i) {
+                if (requests[i].client != -1) reply_request(server, requests + i, 0);
+            }
+        } else {
+            slave_proc(opts);
+        }
+    }
+
+    if (server != NULL) {
+        close_server(server);
+    }
+
+    opts->server = NULL;
+    opts->requests = NULL;
+
+    free(requests);
+    free(server);
+
+    return retval;
+}
+
+/*
+ * set up a batch of requests as frames of a sequence, whose keyframes are the 
+ * views of the requests. all requests of a batch have the same size
+ */
+static void set_batch(mo_request_t *requests, int count, mo_opts_t *opts)
+{
+    opts->width = requests[0].width;
+    opts->height = requests[0].height;
+    opts->requests = requests;
+    opts->keyframe_count = count;
+    opts->frame_count = count;
+    opts->iteration_size = 2;
+
+    for (int i = 0; i < count; ++i) {
+        opts->keyframes[i] = requests[i].view;
+
+        /* iteration counts are sent in the narrowest type that holds them */
+        if (requests[i].view.max_iterations > 0xffff) opts->iteration_size = 4;
+    }
+
+    init_blocks(opts);
+    set_frame(0, opts);
+}
+
+/*
+ * start accepting requests on the unix domain socket of the render server, or 
+ * on stdin. in that case replies are written to stdout, all other output goes
+ * to stderr
+ */
+static int open_server(mo_server_t *server, mo_opts_t *opts)
+{
+    struct sockaddr_un address;
+    struct stat st;
+
+    server->listen_fd = -1;
+    server->path = NULL;
+    server->pending = NULL;
+    server->pending_count = 0;
+    server->pending_size = 0;
+    server->quit = 0;
+
+    for (int i = 0; i < MO_MAXCLIENTS; ++i) {
+        server->clients[i].fd = -1;
+    }
+
+    /* options missing in requests are taken from the command line */
+    server->defaults.view.x = strtold(opts->x_str, NULL);
+    server->defaults.view.y = strtold(opts->y_str, NULL);
+    server->defaults.view.axis_length = opts->axis_length;
+    server->defaults.view.max_iterations = opts->max_iterations;
+    server->defaults.width = opts->width;
+    server->defaults.height = opts->height;
+    server->defaults.min_color = opts->min_color;
+    server->defaults.max_color = opts->max_color;
+    server->defaults.client = -1;
+    server->defaults.time = 0;
+    snprintf(server->defaults.filename, MO_PATHLEN, "%s", opts->filename);
+
+    /* a client which is gone must not take the server down */
+    signal(SIGPIPE, SIG_IGN);
+
+    if (strcmp(opts->serve, "-") == 0) {
+        mo_client_t *client = server->clients;
+
+        client->fd = STDIN_FILENO;
+        client->reply_fd = dup(STDOUT_FILENO);
+        client->eof = 0;
+        client->outstanding = 0;
+        client->length = 0;
+
+        if (client->reply_fd == -1 || dup2(STDERR_FILENO, STDOUT_FILENO) == -1) {
+            eprintf("unable to redirect stdout.\n");
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    if (strlen(opts->serve) >= sizeof(address.sun_path)) {
+        eprintf("socket name '%s' is too long.\n", opts->serve);
+        return EXIT_FAILURE;
+    }
+
+    /* a socket left behind by a previous server is replaced */
+    if (stat(opts->serve, &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(opts->serve);
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, opts->serve);
+
+    if ((server->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1 || 
+            bind(server->listen_fd, (struct sockaddr *) &address, sizeof(address)) != 0 || 
+            listen(server->listen_fd, MO_MAXCLIENTS) != 0) {
+        eprintf("unable to listen on socket '%s'.\n", opts->serve);
+        return EXIT_FAILURE;
+    }
+
+    server->path = opts->serve;
+    printf("Listening on '%s'.\n", opts->serve);
+    fflush(stdout);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * close all connections of the render server and remove its socket
+ */
+static void close_server(mo_server_t *server)
+{
+    for (int i = 0; i < MO_MAXCLIENTS; ++i) {
+        if (server->clients[i].fd != -1) close_client(server->clients + i);
+    }
+
+    if (server->listen_fd != -1) close(server->listen_fd);
+
+    if (server->path != NULL) unlink(server->path);
+
+    free(server->pending);
+}
+
+/*
+ * wait for requests and take the next batch from the pending ones: the 
+ * oldest request and up to MO_MAXBATCH - 1 later ones of the same size, so
+ * requests which arrive together are rendered in one schedule. returns the 
+ * # of requests of the batch, 0 once the server is stopped
+ */
+static int next_batch(mo_server_t *server, mo_request_t *requests)
+{
+    int count = 0;
+    int kept = 0;
+
+    /* block until there is a request, the ones which arrived meanwhile are read
+     * right away */
+    do {
+        poll_server(server, (server->pending_count > 0 || server->quit) ? 0 : -1);
+    } while (server->pending_count == 0 && !server->quit);
+
+    for (int i = 0; i < server->pending_count; ++i) {
+        mo_request_t *request = server->pending + i;
+
+        if (count < MO_MAXBATCH && (count == 0 || (request->width == requests[0].width && 
+                request->height == requests[0].height))) {
+            requests[count++] = *request;
+        } else {
+            server->pending[kept++] = *request;
+        }
+    }
+
+    server->pending_count = kept;
+
+    return count;
+}
+
+/*
+ * wait up to `timeout` milliseconds (-1 = forever) for connections and 
+ * requests, which are read and queued
+ */
+static void poll_server(mo_server_t *server, int timeout)
+{
+    struct pollfd fds[MO_MAXCLIENTS + 1];
+    int clients[MO_MAXCLIENTS + 1];
+    int count = 0;
+    int fd, i;
+
+    /* once stopped, the pending requests are rendered, but no more read */
+    for (i = 0; i < MO_MAXCLIENTS && !server->quit; ++i) {
+        if (server->clients[i].fd != -1 && !server->clients[i].eof) {
+            fds[count].fd = server->clients[i].fd;
+            fds[count].events = POLLIN;
+            clients[count++] = i;
+        }
+    }
+
+    if (server->listen_fd != -1 && !server->quit) {
+        fds[count].fd = server->listen_fd;
+        fds[count].events = POLLIN;
+        clients[count++] = -1;
+    }
+
+    if (count == 0 || poll(fds, count, timeout) <= 0) return;
+
+    for (int j = 0; j < count; ++j) {
+        if (!(fds[j].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        if (clients[j] != -1) {
+            read_requests(server, clients[j]);
+            continue;
+        }
+
+        /* new connections are refused if all slots are taken */
+        if ((fd = accept(server->listen_fd, NULL, NULL)) == -1) continue;
+
+        for (i = 0; i < MO_MAXCLIENTS && server->clients[i].fd != -1; ++i);
+
+        if (i == MO_MAXCLIENTS) {
+            close(fd);
+            continue;
+        }
+
+        server->clients[i].fd = fd;
+        server->clients[i].reply_fd = fd;
+        server->clients[i].eof = 0;
+        server->clients[i].outstanding = 0;
+        server->clients[i].length = 0;
+    }
+}
+
+/*
+ * read from a client and queue the requests of all complete lines. invalid 
+ * requests are answered right away. 'quit' stops the server, so does the 
+ * end of stdin
+ */
+static void read_requests(mo_server_t *server, int index)
+{
+    mo_client_t *client = server->clients + index;
+    mo_request_t *request;
+    char *line, *end;
+    ssize_t length = read(client->fd, client->buffer + client->length, 
+            MO_REQUESTLEN - 1 - client->length);
+
+    if (length == -1 && errno == EINTR) return;
+
+    if (length > 0) {
+        client->length += length;
+    } else {
+        client->eof = 1;
+
+        if (server->listen_fd == -1) server->quit = 1;
+
+        /* the last line may lack its newline */
+        if (client->length > 0) client->buffer[client->length++] = '\n';
+    }
+
+    for (line = client->buffer; (end = (char *) memchr(line, '\n', 
+            client->buffer + client->length - line)) != NULL; line = end + 1) {
+        *end = '\0';
+        line += strspn(line, " \t\r");
+
+        if (*line == '\0' || *line == '#') continue;
+
+        if (strncmp(line, "quit", 4) == 0 && line[4 + strspn(line + 4, " \t\r")] == '\0') {
+            server->quit = 1;
+            continue;
+        }
+
+        /* the queue of pending requests grows by doubling */
+        if (server->pending_count == server->pending_size) {
+            int size = (server->pending_size > 0) ? 2*server->pending_size : MO_MAXBATCH;
+            mo_request_t *pending = (mo_request_t *) realloc(server->pending, 
+                    size*sizeof(*pending));
+
+            if (pending == NULL) {
+                dprintf(client->reply_fd, "error out of memory\n");
+                continue;
+            }
+
+            server->pending = pending;
+            server->pending_size = size;
+        }
+
+        request = server->pending + server->pending_count;
+
+        if (parse_request(line, request, &server->defaults) != EXIT_SUCCESS) {
+            dprintf(client->reply_fd, "error invalid request\n");
+            continue;
+        }
+
+        request->client = index;
+        request->time = MPI_Wtime();
+        ++client->outstanding;
+        ++server->pending_count;
+    }
+
+    /* keep the incomplete line, lines exceeding the buffer are dropped */
+    client->length -= line - client->buffer;
+    memmove(client->buffer, line, client->length);
+
+    if (client->length == MO_REQUESTLEN - 1) {
+        dprintf(client->reply_fd, "error request too long\n");
+        client->length = 0;
+    }
+
+    if (client->eof && client->outstanding == 0) {
+        close_client(client);
+    }
+}
+
+/*
+ * parse a request: pairs of an option and its value, options which are 
+ * missing are taken from `defaults`
+ */
+static int parse_request(char *line, mo_request_t *request, mo_request_t *defaults)
+{
+    char *option, *value, *state;
+
+    *request = *defaults;
+
+    for (option = strtok_r(line, " \t\r", &state); option != NULL; 
+            option = strtok_r(NULL, " \t\r", &state)) {
+        value = strtok_r(NULL, " \t\r", &state);
+
+        if (value == NULL || option[0] != '-' || option[1] == '\0' || option[2] != '\0') {
+            return EXIT_FAILURE;
+        }
+
+        switch (option[1]) {
+            case 'c': request->width = atoi(value); break;
+            case 'r': request->height = atoi(value); break;
+            case 'n': request->view.max_iterations = atoi(value); break;
+            case 'x': request->view.x = strtold(value, NULL); break;
+            case 'y': request->view.y = strtold(value, NULL); break;
+            case 'a': request->view.axis_length = atof(value); break;
+            case 'p': request->min_color = strtol(value, NULL, 16); break;
+            case 'q': request->max_color = strtol(value, NULL, 16); break;
+            case 'o':
+                if (strlen(value) >= MO_PATHLEN) return EXIT_FAILURE;
+
+                strcpy(request->filename, value);
+                break;
+            default:
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (request->width <= 0 || request->height <= 0 || request->view.max_iterations <= 0 || 
+            request->view.axis_length == 0) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * answer a request with the time since its arrival. clients which are gone 
+ * are closed once all of their requests are answered
+ */
+static void reply_request(mo_server_t *server, mo_request_t *request, int ok)
+{
+    mo_client_t *client = server->clients + request->client;
+
+    if (ok) {
+        dprintf(client->reply_fd, "ok %s %.3f\n", request->filename, 
+                MPI_Wtime() - request->time);
+    } else {
+        dprintf(client->reply_fd, "error %s\n", request->filename);
+    }
+
+    request->client = -1;
+
+    if (--client->outstanding == 0 && client->eof) {
+        close_client(client);
+    }
+}
+
+/*
+ * close the connection of a client
+ */
+static void close_client(mo_client_t *client)
+{
+    if (client->reply_fd != client->fd) close(client->reply_fd);
+
+    close(client->fd);
+    client->fd = -1;
+}
+
+/*
+ * gather the events of all processes on process 0 and write them to the trace
+ * file in chrome's trace event format (chrome://tracing, ui.perfetto.dev), 
+ * one track per process. a summary of the utilization of each process is 
+ * displayed as well: the share of the traced time spent computing
+ */
+static void write_trace(int proc_id, int proc_count, mo_opts_t *opts)
+{
+    mo_trace_t *trace = opts->trace;
+    int size = trace->count*sizeof(*trace->events);
+    int *sizes = NULL, *offsets = NULL;
+    mo_event_t *events = NULL;
+    int ok = 1, count = 0;
+    FILE *file;
+
+    if (trace->dropped > 0) {
+        eprintf("unable to allocate memory for %d trace events of process %d.\n", 
+                trace->dropped, proc_id);
+    }
+
+    if (proc_id == 0) {
+        sizes = (int *) malloc(proc_count*sizeof(*sizes));
+        offsets = (int *) malloc(proc_count*sizeof(*offsets));
+        ok = (sizes != NULL && offsets != NULL);
+    }
+
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (ok) {
+        MPI_Gather(&size, 1, MPI_INT, sizes, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+        for (int p = 0; proc_id == 0 && p < proc_count; ++p) {
+            offsets[p] = count*sizeof(*events);
+            count += sizes[p]/sizeof(*events);
+        }
+
+        ok = (proc_id != 0 || (events = (mo_event_t *) malloc(
+                        (count > 0 ? count : 1)*sizeof(*events))) != NULL);
+
+        MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    if (ok) {
+        MPI_Gatherv(trace->events, size, MPI_BYTE, events, sizes, offsets, MPI_BYTE, 0, 
+                MPI_COMM_WORLD);
+    } else if (proc_id == 0) {
+        eprintf("unable to allocate memory for trace.\n");
+    }
+
+    if (proc_id != 0 || !ok) {
+        free(sizes); free(offsets); free(events);
+        return;
+    }
+
+    if ((file = fopen(trace->filename, "w")) == NULL) {
+        eprintf("unable to open file '%s'.\n", trace->filename);
+        free(sizes); free(offsets); free(events);
+        return;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int p = 0; p < proc_count; ++p) {
+        fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d," \
+            "\"args\":{\"name\":\"rank %d%s\"}}%s\n", p, p, 
+            (p == 0 && !opts->rma) ? " (master)" : "", 
+            (p < proc_count - 1 || count > 0) ? "," : "");
+    }
+
+    /* events are in the order of the processes */
+    double span = 0;
+    double busy[MO_EVENTS];
+    int blocks, last;
+
+    for (int p = 0, i = 0; p < proc_count; ++p) {
+        for (last = i + sizes[p]/sizeof(*events); i < last; ++i) {
+            mo_event_t *event = events + i;
+
+            if (event->end > span) span = event->end;
+
+            fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d," \
+                "\"tid\":0,\"ts\":%.3f,\"dur\":%.3f", event_types[event->type], 
+                (event->block.index == -1) ? "wait" : "block", p, 1e6*event->start, 
+                1e6*(event->end - event->start));
+
+            if (event->block.index != -1) {
+                fprintf(file, ",\"args\":{\"block\":%" PRId64 ",\"frame\":%d,\"col\":%d," \
+                    "\"row\":%d,\"cols\":%d,\"rows\":%d,\"iterations\":%.0f}", 
+                    event->block.index, event->block.frame, event->block.col, 
+                    event->block.row, event->block.cols, event->block.rows, 
+                    event->iterations);
+            }
+
+            fprintf(file, "}%s\n", (i < count - 1) ? "," : "");
+        }
+    }
+
+    fprintf(file, "]}\n");
+
+    if (fclose(file) != 0) {
+        eprintf("unable to write file '%s'.\n", trace->filename);
+    } else {
+        printf("\nTrace stored in '%s'. Utilization per process:\n" \
+            "    rank   blocks  compute s     recv s     send s    color s    write s   busy\n",
+            trace->filename);
+    }
+
+    for (int p = 0, i = 0; p < proc_count; ++p) {
+        memset(busy, 0, sizeof(busy));
+        blocks = 0;
+
+        for (last = i + sizes[p]/sizeof(*events); i < last; ++i) {
+            busy[events[i].type] += events[i].end - events[i].start;
+            blocks += (events[i].type == MO_EV_COMPUTE);
+        }
+
+        printf("    %4d %8d %10.3f %10.3f %10.3f %10.3f %10.3f %5.1f%%\n", p, blocks, 
+                busy[MO_EV_COMPUTE], busy[MO_EV_RECV], busy[MO_EV_SEND], 
+                busy[MO_EV_COLOR] + busy[MO_EV_DECODE], busy[MO_EV_WRITE], 
+                (span > 0) ? 100*busy[MO_EV_COMPUTE]/span : 0);
+    }
+
+    free(sizes);
+    free(offsets);
+    free(events);
+}
+
+/*
+ * sum up the statistics of all processes on process 0, display them and 
+ * append them as a line to the csv file, which starts with a header line. 
+ * phase times are the maxima over all processes, the imbalance is the ratio 
+ * of the maximum to the mean compute time of the processes computing blocks
+ */
+static void report_stats(int proc_id, int proc_count, mo_opts_t *opts)
+{
+    const int workers = opts->rma ? proc_count : proc_count - 1 - opts->node_count;
+    mo_stats_t max, sum;
+    FILE *file;
+
+    MPI_Reduce(&opts->stats, &max, MO_STATS, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&opts->stats, &sum, MO_STATS, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (proc_id != 0 || max.seconds <= 0) return;
+
+    const double mpixels = (double) opts->width*opts->height*opts->frame_count/
+        max.seconds/1e6;
+    const double giterations = sum.iterations/max.seconds/1e9;
+    const double imbalance = (sum.compute > 0) ? max.compute*workers/sum.compute : 1;
+
+    printf("\nStatistics:\n" \
+        "    Mpixels/s                %.3f\n" \
+        "    Giterations/s            %.3f\n" \
+        "    compute                  %.3f sec\n" \
+        "    communication            %.3f sec\n" \
+        "    color mapping            %.3f sec\n" \
+        "    write                    %.3f sec\n" \
+        "    load imbalance           %.3f\n",
+        mpixels, giterations, max.compute, max.communication, max.color, max.write, 
+        imbalance);
+
+    if ((file = fopen(opts->stats_file, "a")) == NULL) {
+        eprintf("unable to open file '%s'.\n", opts->stats_file);
+        return;
+    }
+
+    if (fseek(file, 0, SEEK_END) == 0 && ftell(file) == 0) {
+        fprintf(file, "processes,width,height,frames,max_iterations,blocksize,block_width," \
+            "schedule,mode,kernel,precision,output,x,y,axis_length,seconds,mpixels_per_s," \
+            "giterations_per_s,compute_s,communication_s,color_s,write_s,imbalance\n");
+    }
+
+    fprintf(file, "%d,%d,%d,%d,%d,%d,%d,%s,%s,%s,%s,%s,%s,%s,%g,%.6f,%.6f,%.6f,%.6f,%.6f," \
+        "%.6f,%.6f,%.6f\n", 
+        proc_count, opts->width, opts->height, opts->frame_count, opts->max_iterations, 
+        opts->blocksize, opts->block_width, schedules[opts->schedule], modes[opts->mode], 
+        (opts->cache_dir != NULL) ? "scalar" : pixel_kernel(opts)->name, 
+        (opts->precision == MO_PREC_LONG) ? "long double" : precisions[opts->precision], 
+        opts->rma ? "rma" : (opts->mpi_io ? "mpi-io" : "master"), opts->x_str, opts->y_str, 
+        opts->axis_length, max.seconds, mpixels, giterations, max.compute, 
+        max.communication, max.color, max.write, imbalance);
+
+    if (fclose(file) != 0) {
+        eprintf("unable to write file '%s'.\n", opts->stats_file);
+    }
+}
+
+/*
+ * master process logic
+ */
+static int master_proc(int slave_count, mo_opts_t *opts) 
+{
+    const int slots = slave_count*opts->depth;
+    const int max_cols = (opts->block_width < opts->width) ? opts->block_width : opts->width;
+    const int64_t data_size = result_size(opts);
+    const size_t lines_size = (size_t) block_line_size(max_cols, opts)*opts->max_rows;
+
+    mo_block_t *blocks = (mo_block_t *) malloc(slots*sizeof(*blocks));
+    char *data = (data_size <= INT_MAX) ? (char *) malloc(2*data_size*sizeof(*data)) : NULL;
+    char *lines = opts->mpi_io ? NULL : (char *) calloc(lines_size, sizeof(*lines));
+    int *queued = (int *) calloc(slave_count + 1, sizeof(*queued));
+    int *sent = (int *) calloc(slave_count + 1, sizeof(*sent));
+    MPI_Request *requests = (MPI_Request *) malloc(slots*sizeof(*requests));
+    int *fds = (int *) malloc(opts->frame_count*sizeof(*fds));
+    int64_t *frame_pixels = (int64_t *) calloc(opts->frame_count, sizeof(*frame_pixels));
+    int *cached = (opts->cache_dir != NULL) 
+        ? (int *) malloc((size_t) max_cols*opts->max_rows*sizeof(*cached)) 
+        : NULL;
+    const int64_t block_count = (opts->checkpoint != NULL) ? schedule_blocks(NULL, NULL, opts) : 0;
+    const size_t done_size = (block_count + 7)/8;
+    unsigned char *done = (opts->checkpoint != NULL) 
+        ? (unsigned char *) calloc(done_size, sizeof(*done)) 
+        : NULL;
+    mo_checkpoint_t *checkpoint = (opts->checkpoint != NULL) 
+        ? (mo_checkpoint_t *) malloc(sizeof(*checkpoint) + done_size) 
+        : NULL;
+    int *partition = (opts->schedule == MO_SCHED_STATIC) 
+        ? (int *) malloc((slave_count + 1)*sizeof(*partition)) 
+        : NULL;
+    int *grid = (opts->mode == MO_MODE_PROGRESSIVE) 
+        ? (int *) malloc((size_t) ((opts->width + 1)/2)*((opts->height + 1)/2)*sizeof(*grid)) 
+        : NULL;
+    mo_pyramid_t pyramid = { NULL, NULL, NULL, 0, NULL, 0, 0 };
+    mo_slaves_t slaves = { blocks, requests, queued, sent, 0 };
+    char filename[MO_PATHLEN];
+    int retval = EXIT_SUCCESS; 
+    MPI_File fh, checkpoint_fh;
+
+    /* result messages are received in one piece, their size is an MPI count */
+    if (data_size > INT_MAX) {
+        eprintf("result messages of %lld bytes exceed the counts of MPI.\n", 
+                (long long) data_size);
+        retval = EXIT_FAILURE;
+    } else if (blocks == NULL || data == NULL || (lines == NULL && !opts->mpi_io) || 
+            queued == NULL || sent == NULL || requests == NULL || fds == NULL || 
+            frame_pixels == NULL || (cached == NULL && opts->cache_dir != NULL) || 
+            (opts->checkpoint != NULL && (done == NULL || checkpoint == NULL)) || 
+            (partition == NULL && opts->schedule == MO_SCHED_STATIC) || 
+            (grid == NULL && opts->mode == MO_MODE_PROGRESSIVE)) {
+        eprintf("unable to allocate memory for buffers.\n");
+        retval = EXIT_FAILURE;
+    }
+
+    for (int i = 0; fds != NULL && i < opts->frame_count; ++i) {
+        fds[i] = -1;
+    }
+
+    if (opts->mpi_io) {
+        /* the slaves write their rows themselves, only write the header */
+        retval = open_bitmap_mpi(&fh, retval, 1, opts);
+    } else if (retval == EXIT_SUCCESS && opts->tiles != NULL) {
+        /* the slaves write the tiles themselves */
+        retval = init_pyramid(&pyramid, slave_count, opts);
+    } else if (retval == EXIT_SUCCESS) {
+        /* files of later frames are opened once their first block arrives */
+        frame_filename(filename, 0, opts);
+        fds[0] = open_bitmap(filename, opts->width, opts->height, opts->resume);
+
+        if (fds[0] == -1) retval = EXIT_FAILURE;
+    }
+
+    /* blocks stored before the render was interrupted are skipped */
+    if (retval == EXIT_SUCCESS && opts->checkpoint != NULL) {
+        init_checkpoint(checkpoint, block_count, opts);
+
+        if (opts->resume && load_checkpoint(checkpoint, done, opts) != EXIT_SUCCESS) {
+            retval = EXIT_FAILURE;
+        } else if (MPI_File_open(MPI_COMM_SELF, opts->checkpoint, 
+                MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL, 
+                &checkpoint_fh) != MPI_SUCCESS) {
+            eprintf("unable to open checkpoint '%s'.\n", opts->checkpoint);
+            retval = EXIT_FAILURE;
+        } else {
+            /* the checkpoint is valid right away, so a render killed before the 
+             * first snapshot is resumed from its start */
+            memcpy(checkpoint + 1, done, done_size);
+
+            if (MPI_File_write_at(checkpoint_fh, 0, checkpoint, sizeof(*checkpoint) + done_size, 
+                    MPI_BYTE, MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+                eprintf("unable to write checkpoint '%s'.\n", opts->checkpoint);
+                MPI_File_close(&checkpoint_fh);
+                retval = EXIT_FAILURE;
+            }
+        }
+    }
+
+    if (retval != EXIT_SUCCESS) {
+        /* slaves are waiting for work, so send them to sleep before giving up */
+        for (int p = 1; !opts->mpi_io && p <= slave_count; ++p) {
+            MPI_Send(NULL, 0, MPI_INT, p, MO_STOP, opts->comm);
+        }
+
+        if (fds != NULL && fds[0] != -1) close(fds[0]);
+
+        free(blocks); free(data); free(lines); free(queued); free(sent); free(requests);
+        free(fds); free(frame_pixels); free(cached); free(done); free(checkpoint);
+        free(partition); free(grid); free(pyramid.offsets); free(pyramid.children); 
+        free(pyramid.pending); free(pyramid.idle);
+        return EXIT_FAILURE;
+    }
+    
+    const int64_t pixel_count = (int64_t) opts->width*opts->height;
+    const int first_step = (opts->mode == MO_MODE_PROGRESSIVE) ? MO_PASSSTEP : 1;
+    const int64_t progress_count = progress_total(opts);
+    int proc_id, step, end_tag; 
+    double start_time, end_time, checkpoint_time;
+    mo_block_header_t *header;
+    mo_scale_t scale;
+    mo_sched_t sched = { 0, 0, 0, 0, 0 };
+    mo_opts_t grid_opts, *sched_opts;
+    mo_cache_t cache = { fds[0], cached, lines, &scale, 0, EXIT_SUCCESS };
+    mo_frames_t frames = { fds, frame_pixels, 0, lines, &scale, done };
+    int64_t pixels_processed = 0;
+    int current_buffer = 0;
+    double time;
+    
+    MPI_Status status;
+    MPI_Request recv_request;
+    MPI_Request checkpoint_request = MPI_REQUEST_NULL;
+
+    /* pixels of frames which were partially stored count as processed */
+    if (opts->resume) {
+        retval = open_resumed(&frames, &pixels_processed, opts);
+    }
+
+    for (int i = 0; i < slots; ++i) {
+        requests[i] = MPI_REQUEST_NULL;
+    }
+
+    init_scale(&scale, opts);
+
+    printf("Computation started.\n");
+    
+    /* get start time */
+    start_time = MPI_Wtime();
+    checkpoint_time = start_time;
+
+    if (partition != NULL) {
+        plan_partition(partition, slave_count, &scale, opts);
+        opts->partition = partition;
+    }
+    
+    /* the progressive mode renders passes of every `step`-th pixel of every `step`-th
+     * row first, halving `step` down to 1. blocks of these passes are scheduled on 
+     * the grid of their pixels and a preview is stored after each of them */
+    for (step = first_step; ; step /= 2) {
+        if (step > 1) {
+            grid_opts = *opts;
+            grid_opts.width = (opts->width + step - 1)/step;
+            grid_opts.height = (opts->height + step - 1)/step;
+            sched_opts = &grid_opts;
+        } else {
+            sched_opts = opts;
+        }
+
+        /* slaves wait for the grid of the pass once they are done with it */
+        end_tag = (step > 1) ? MO_PASS : MO_STOP;
+        memset(&sched, 0, sizeof(sched));
+
+        /* assign each slave up to `depth` initial blocks, so it never has to wait 
+         * for the master to assign the next block */
+        for (int d = 0; d < opts->depth; ++d) {
+            for (int p = 1; p <= slave_count && sched.frame < opts->frame_count; ++p) {
+                refill_slave(p, &slaves, &sched, &pyramid, &cache, done, sched_opts);
+            }
+        }
+
+        /* send slaves without any work to sleep right away */
+        for (int p = 1; p <= slave_count; ++p) {
+            if (queued[p] == 0) release_slave(p, &pyramid, end_tag, opts);
+        }
+
+        MPI_Irecv(data + current_buffer*data_size, (int) data_size, MPI_BYTE, MPI_ANY_SOURCE, 
+                MO_DATA, opts->comm, &recv_request);
+
+        /* reveice results from slaves until all blocks are processed */
+        while (slaves.running > 0) {
+            time = begin_event(opts);
+            MPI_Wait(&recv_request, &status);
+            end_event(MO_EV_RECV, time, NULL, NULL, opts);
+
+            --slaves.running;
+            proc_id = status.MPI_SOURCE;
+            --queued[proc_id];
+            header = (mo_block_header_t *) (data + current_buffer*data_size);
+
+            /* a finished tile completes its parent once all children are finished */
+            if (opts->tiles != NULL) {
+                if (header->encoding == MO_FAILED) retval = EXIT_FAILURE;
+
+                finish_tile(&header->block, &pyramid, opts);
+            }
+
+            /* if there is still work left, refill the slave's queue, otherwise 
+             * release him once his queue is empty */
+            if (refill_slave(proc_id, &slaves, &sched, &pyramid, &cache, done, 
+                    sched_opts) == 0 && queued[proc_id] == 0) {
+                release_slave(proc_id, &pyramid, end_tag, opts);
+            }
+
+            assign_idle(&slaves, &pyramid, end_tag, opts);
+
+            /* receive next result into the other buffer while this one is decoded */
+            current_buffer ^= 1;
+
+            if (slaves.running > 0) {
+                MPI_Irecv(data + current_buffer*data_size, (int) data_size, MPI_BYTE, MPI_ANY_SOURCE, 
+                        MO_DATA, opts->comm, &recv_request);
+            }
+
+            /* write colors of the received block straight to its position in the file,
+             * unless the slave did that itself. blocks of previews are merged into the 
+             * grid of their pass */
+            if (step > 1) {
+                time = begin_event(opts);
+                decode_grid(header, grid, sched_opts->width, opts);
+                end_event(MO_EV_DECODE, time, &header->block, NULL, opts);
+            } else if (header->encoding != MO_WRITTEN && header->encoding != MO_FAILED) {
+                if (store_block(header, &frames, &cache, opts) != EXIT_SUCCESS) {
+                    retval = EXIT_FAILURE;
+                }
+            }
+
+            /* only show progress if option set */
+            if (opts->show_progress) {
+                pixels_processed += (int64_t) header->block.cols*
+                    (header->block.rows + mirrored_rows(&header->block, opts));
+                print_progress(pixels_processed + cache.pixels, progress_count);
+            }
+
+            if (done != NULL && MPI_Wtime() - checkpoint_time >= opts->checkpoint_interval && 
+                    snapshot_checkpoint(checkpoint_fh, checkpoint, done, done_size, 
+                    &checkpoint_request)) {
+                checkpoint_time = MPI_Wtime();
+            }
+        }
+
+        if (step == 1) break;
+
+        time = begin_event(opts);
+
+        if (write_preview(fds[0], grid, step, lines, &scale, opts) != EXIT_SUCCESS) {
+            retval = EXIT_FAILURE;
+        }
+
+        end_event(MO_EV_WRITE, time, NULL, NULL, opts);
+
+        printf("%sPreview of %dx%d pixels stored after %g sec.\n", 
+                opts->show_progress ? "\033[K" : "", grid_opts.width, grid_opts.height, 
+                MPI_Wtime() - start_time);
+
+        /* the slaves guess pixels of the next pass from the iteration counts */
+        MPI_Bcast(grid, grid_opts.width*grid_opts.height, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    if (cache.retval != EXIT_SUCCESS) {
+        retval = EXIT_FAILURE;
+    }
+
+    /* the frame is complete, which is not noticed if all blocks were cached */
+    if (fds[0] != -1 && frame_pixels[0] + cache.pixels == pixel_count) {
+        if (close(fds[0]) != 0) retval = EXIT_FAILURE;
+    }
+
+    /* all blocks were received, so all sends are complete */
+    MPI_Waitall(slots, requests, MPI_STATUSES_IGNORE);
+
+    if (done != NULL) {
+        close_checkpoint(&checkpoint_fh, checkpoint, done, done_size, &checkpoint_request, opts);
+    }
+
+    /* get end time  */
+    end_time = MPI_Wtime();
+    opts->stats.seconds += end_time - start_time;
+
+    /* clear progress bar from stdout */
+    if (opts->show_progress) printf("\033[K");
 
     printf("Finished. Computation finished in %g sec.\n\n", end_time - start_time);
 
-    /* write rgb data to file */
-    printf("Creating bitmap image.\n");
-    retval = write_bitmap(opts->filename, opts->width, opts->height, rgb);
+    if (opts->cache_dir != NULL) {
+        printf("Finished. %.1f%% of the pixels read from the tile cache.\n", 
+                100.0*cache.pixels/pixel_count);
+    }
+
+    /* waits until all slaves finished writing */
+    if (opts->mpi_io && MPI_File_close(&fh) != MPI_SUCCESS) {
+        retval = EXIT_FAILURE;
+    }
+
+    if (retval != EXIT_SUCCESS) {
+        eprintf("failed to write bitmap to file.\n");
+    } else if (opts->keyframes != NULL) {
+        printf("Finished. %d frames stored.\n", opts->frame_count);
+    } else if (opts->tiles != NULL) {
+        printf("Finished. Tile pyramid of %d levels stored in '%s.dzi'.\n", 
+                opts->tile_levels, opts->tiles);
+    } else {
+        printf("Finished. Image stored in '%s'.\n", opts->filename);
+    }
+    
+    free(blocks);
+    free(data);
+    free(lines);
+    free(queued);
+    free(sent);
+    free(requests);
+    free(fds);
+    free(frame_pixels);
+    free(cached);
+    free(done);
+    free(checkpoint);
+    free(partition);
+    free(grid);
+    free(pyramid.offsets);
+    free(pyramid.children);
+    free(pyramid.pending);
+    free(pyramid.idle);
+    opts->partition = NULL;
+
+    return retval;
+}
+
+/*
+ * total # of pixels the progress is measured in: those of all frames, the 
+ * previews of the progressive mode and the coarser levels of the tile pyramid
+ */
+static int64_t progress_total(mo_opts_t *opts)
+{
+    int64_t total = (int64_t) opts->width*opts->height*opts->frame_count;
+    int width, height;
+
+    if (opts->mode == MO_MODE_PROGRESSIVE) {
+        for (int step = MO_PASSSTEP; step > 1; step /= 2) {
+            total += (int64_t) ((opts->width + step - 1)/step)*((opts->height + step - 1)/step);
+        }
+    }
+
+    for (int level = 1; level < opts->tile_levels; ++level) {
+        level_size(level, &width, &height, opts);
+        total += (int64_t) width*height;
+    }
+
+    return total;
+}
+
+/*
+ * count the pixels stored before a render was resumed. files of frames which 
+ * were partially stored are opened right away, later frames are opened once 
+ * their first block arrives
+ */
+static int open_resumed(mo_frames_t *frames, int64_t *pixels_processed, mo_opts_t *opts)
+{
+    const int64_t pixel_count = (int64_t) opts->width*opts->height;
+    char filename[MO_PATHLEN];
+    int retval = EXIT_SUCCESS;
+
+    schedule_blocks(frames->done, frames->pixels, opts);
+
+    for (int frame = 0; frame < opts->frame_count; ++frame) {
+        *pixels_processed += frames->pixels[frame];
+
+        if (frame > 0 && frames->pixels[frame] > 0 && frames->pixels[frame] < pixel_count) {
+            frame_filename(filename, frame, opts);
+            frames->fds[frame] = open_bitmap(filename, opts->width, opts->height, 1);
+
+            if (frames->fds[frame] == -1) retval = EXIT_FAILURE;
+        }
+    }
+
+    return retval;
+}
+
+/*
+ * queue the next work on a slave: pending tiles of the pyramid go first, so 
+ * finished levels are not held back by the computation. returns the # of 
+ * result messages queued or 0 if no work was left
+ */
+static int refill_slave(int proc_id, mo_slaves_t *slaves, mo_sched_t *sched, 
+        mo_pyramid_t *pyramid, mo_cache_t *cache, unsigned char *done, mo_opts_t *opts)
+{
+    const int slot = (proc_id - 1)*opts->depth + slaves->sent[proc_id] % opts->depth;
+    int pieces = 0;
+
+    if (pyramid->pending_count > 0) {
+        pieces = queue_tile(proc_id, pyramid, slaves->blocks + slot, slaves->requests + slot);
+    } else if (sched->frame < opts->frame_count) {
+        pieces = queue_block(proc_id, sched, slaves->blocks + slot, slaves->requests + slot, 
+                cache, done, opts);
+    }
+
+    if (pieces > 0) {
+        ++slaves->sent[proc_id];
+        slaves->queued[proc_id] += pieces;
+        slaves->running += pieces;
+    }
+
+    return pieces;
+}
+
+/*
+ * send a slave without work to sleep, unless it is needed for tiles of the 
+ * pyramid which are not finished yet
+ */
+static void release_slave(int proc_id, mo_pyramid_t *pyramid, int tag, mo_opts_t *opts)
+{
+    if (pyramid->remaining > 0) {
+        pyramid->idle[pyramid->idle_count++] = proc_id;
+    } else {
+        MPI_Send(NULL, 0, MPI_INT, proc_id, tag, opts->comm);
+    }
+}
+
+/*
+ * idle slaves downsample pending tiles. once all tiles are finished, they are 
+ * sent to sleep
+ */
+static void assign_idle(mo_slaves_t *slaves, mo_pyramid_t *pyramid, int tag, mo_opts_t *opts)
+{
+    while (pyramid->idle_count > 0 && 
+            (pyramid->pending_count > 0 || pyramid->remaining == 0)) {
+        const int p = pyramid->idle[--pyramid->idle_count];
+
+        if (pyramid->remaining == 0) {
+            MPI_Send(NULL, 0, MPI_INT, p, tag, opts->comm);
+        } else {
+            /* pending tiles go first, so no block is scheduled */
+            refill_slave(p, slaves, NULL, pyramid, NULL, NULL, opts);
+        }
+    }
+}
+
+/*
+ * decode a received block and write its colors to the bitmap of its frame. 
+ * a frame which failed is given up, the others go on. files of completed 
+ * frames are closed, so the next frames can be rendered while they are in use
+ */
+static int store_block(mo_block_header_t *header, mo_frames_t *frames, mo_cache_t *cache, 
+        mo_opts_t *opts)
+{
+    const int64_t pixel_count = (int64_t) opts->width*opts->height;
+    const int frame = header->block.frame;
+    char filename[MO_PATHLEN];
+    int retval = EXIT_SUCCESS, stored;
+    double time;
+
+    /* colors are scaled by the iterations of the block's frame */
+    if (frame != frames->current) {
+        set_frame(frame, opts);
+        init_scale(frames->scale, opts);
+        frames->current = frame;
+    }
+
+    if (frames->pixels[frame] == 0 && frames->fds[frame] == -1) {
+        frame_filename(filename, frame, opts);
+        frames->fds[frame] = open_bitmap(filename, opts->width, opts->height, 0);
+
+        if (frames->fds[frame] == -1) retval = EXIT_FAILURE;
+    }
+
+    time = begin_event(opts);
+    decode_block(header, frames->lines, frames->scale, opts);
+    end_event(MO_EV_DECODE, time, &header->block, NULL, opts);
+
+    time = begin_event(opts);
+
+    if (frames->fds[frame] == -1 || write_bitmap_block(frames->fds[frame], frames->lines, 
+            &header->block, opts) != EXIT_SUCCESS) {
+        retval = EXIT_FAILURE;
+
+        if (frames->fds[frame] != -1) close(frames->fds[frame]);
+
+        frames->fds[frame] = -1;
+    } else if (frames->done != NULL) {
+        frames->done[header->block.index/8] |= 1 << header->block.index % 8;
+    }
+
+    end_event(MO_EV_WRITE, time, &header->block, NULL, opts);
+
+    frames->pixels[frame] += (int64_t) header->block.cols*
+        (header->block.rows + mirrored_rows(&header->block, opts));
+
+    if (frames->pixels[frame] + cache->pixels == pixel_count && frames->fds[frame] != -1) {
+        stored = (close(frames->fds[frame]) == 0);
+
+        if (!stored) retval = EXIT_FAILURE;
+
+        frames->fds[frame] = -1;
+
+        if (opts->keyframes != NULL) {
+            frame_filename(filename, frame, opts);
+            printf("%sFrame %d stored in '%s'.\n", opts->show_progress ? "\033[K" : "", 
+                    frame, filename);
+        }
+
+        /* requests are replied to as soon as they are done */
+        if (opts->server != NULL) {
+            reply_request(opts->server, opts->requests + frame, stored);
+        }
+    }
+
+    return retval;
+}
+
+/*
+ * write a snapshot of the stored blocks to the checkpoint in the background. 
+ * the receive loop never waits for it, if the last one is not out yet, it is 
+ * skipped. bits are only ever set, so even a torn write leaves a valid 
+ * checkpoint. returns 1 if a snapshot was started
+ */
+static int snapshot_checkpoint(MPI_File fh, mo_checkpoint_t *checkpoint, unsigned char *done, 
+        size_t done_size, MPI_Request *request)
+{
+    int flag;
+
+    MPI_Test(request, &flag, MPI_STATUS_IGNORE);
+
+    if (flag) {
+        memcpy(checkpoint + 1, done, done_size);
+        MPI_File_iwrite_at(fh, 0, checkpoint, sizeof(*checkpoint) + done_size, MPI_BYTE, 
+                request);
+    }
+
+    return flag;
+}
+
+/*
+ * write the final checkpoint, which holds all stored blocks, and close it
+ */
+static void close_checkpoint(MPI_File *fh, mo_checkpoint_t *checkpoint, unsigned char *done, 
+        size_t done_size, MPI_Request *request, mo_opts_t *opts)
+{
+    MPI_Wait(request, MPI_STATUS_IGNORE);
+    memcpy(checkpoint + 1, done, done_size);
+
+    if (MPI_File_write_at(*fh, 0, checkpoint, sizeof(*checkpoint) + done_size, MPI_BYTE, 
+            MPI_STATUS_IGNORE) != MPI_SUCCESS || MPI_File_close(fh) != MPI_SUCCESS) {
+        eprintf("unable to write checkpoint '%s'.\n", opts->checkpoint);
+    }
+}
+
+/*
+ * assign the next block to a slave without waiting for completion. request
+ * belongs to the block buffer and is completed before it is reused. blocks 
+ * found in the tile cache are written right away instead, blocks marked in 
+ * `done` (if not NULL) are skipped. returns the # of result messages of the 
+ * block, which are pieces of at most `max_rows` rows, or 0 if no block was 
+ * left to assign
+ */
+static int queue_block(int proc_id, mo_sched_t *sched, mo_block_t *block, 
+        MPI_Request *request, mo_cache_t *cache, unsigned char *done, mo_opts_t *opts)
+{
+    MPI_Wait(request, MPI_STATUS_IGNORE);
+
+    while (next_block(sched, block, opts->workers, opts)) {
+        if (done != NULL && (done[block->index/8] & (1 << block->index % 8))) {
+            continue;
+        }
+
+        if (opts->cache_dir != NULL && write_cached_block(block, cache, opts) == EXIT_SUCCESS) {
+            if (done != NULL) done[block->index/8] |= 1 << block->index % 8;
+            continue;
+        }
+
+        MPI_Isend(block, sizeof(*block), MPI_BYTE, proc_id, MO_CALC, opts->comm, request);
+        return (block->rows + opts->max_rows - 1)/opts->max_rows;
+    }
+
+    return 0;
+}
+
+/*
+ * get the next block of the schedule. blocks are handed out in bands of equal
+ * height from top to bottom, each band is split into blocks of `block_width` 
+ * columns. frames follow each other without a break. returns 0 if all blocks
+ * were handed out
+ */
+static int next_block(mo_sched_t *sched, mo_block_t *block, int slave_count, mo_opts_t *opts)
+{
+    if (sched->frame >= opts->frame_count) return 0;
+
+    /* start a new band, which never crosses frames */
+    if (sched->col == 0) {
+        int64_t remaining = (int64_t) (opts->frame_count - sched->frame)*opts->height - 
+            sched->row;
+
+        /* mirrored rows are not computed */
+        if (opts->mirror > 0) {
+            remaining -= opts->mirrored[opts->height] - opts->mirrored[sched->row];
+        }
+
+        sched->rows = band_rows(remaining, slave_count, opts);
+
+        /* cached tiles are aligned to the pixel lattice */
+        if (opts->cache_dir != NULL) {
+            sched->rows = MO_CACHETILE - lattice_offset(opts->lattice_row + sched->row);
+        }
+
+        /* static chunks end at the next boundary of the partition */
+        if (opts->schedule == MO_SCHED_STATIC) {
+            int chunk = 1;
+
+            while (opts->partition[chunk] <= sched->row) ++chunk;
+
+            sched->rows = opts->partition[chunk] - sched->row;
+        }
+
+        if (sched->rows > opts->height - sched->row) sched->rows = opts->height - sched->row;
+
+        /* bands end before the next mirrored row */
+        for (int i = 1; i < sched->rows && opts->mirror > 0; ++i) {
+            if (is_mirrored(sched->row + i, opts)) sched->rows = i;
+        }
+    }
+
+    block->index = sched->index++;
+    block->frame = sched->frame;
+    block->col = sched->col;
+    block->row = sched->row;
+    block->cols = (opts->cache_dir != NULL) 
+        ? MO_CACHETILE - lattice_offset(opts->lattice_col + sched->col)
+        : opts->block_width;
+    block->rows = sched->rows;
+    block->level = 0;
+
+    if (block->cols > opts->width - sched->col) block->cols = opts->width - sched->col;
+
+    sched->col += block->cols;
+
+    if (sched->col == opts->width) {
+        sched->col = 0;
+        sched->row += sched->rows;
+
+        while (is_mirrored(sched->row, opts)) ++sched->row;
+    }
+
+    if (sched->row == opts->height) {
+        sched->row = 0;
+        ++sched->frame;
+    }
+
+    return 1;
+}
+
+/*
+ * # of rows of the next band if `remaining` rows are left (of all frames). 
+ * the guided schedule (factoring) hands out large blocks first and shrinks 
+ * them towards the end: every round of blocks for all slaves takes half of 
+ * the remaining rows. blocks are at least `blocksize` rows. blocks of all 
+ * schedules are at most MO_MAXBLOCK pixels large, so their result messages 
+ * stay within the counts of MPI
+ */
+static int band_rows(int64_t remaining, int slave_count, mo_opts_t *opts)
+{
+    const int blocks_per_band = (opts->width + opts->block_width - 1)/opts->block_width;
+    const int cols = (opts->block_width < opts->width) ? opts->block_width : opts->width;
+    const int64_t max_rows = (MO_MAXBLOCK/cols > 0) ? MO_MAXBLOCK/cols : 1;
+    int64_t rows = opts->blocksize;
+
+    if (opts->schedule == MO_SCHED_GUIDED) {
+        rows = (remaining*((blocks_per_band < slave_count) 
+                ? blocks_per_band 
+                : slave_count) + 2*slave_count - 1)/(2*slave_count);
+
+        if (rows < opts->blocksize) rows = opts->blocksize;
+    } else if (opts->schedule == MO_SCHED_STATIC) {
+        /* static chunks are computed and sent back in pieces of this size */
+        rows = max_rows;
+    }
+
+    if (rows > max_rows) rows = max_rows;
+
+    return (int) ((rows < remaining) ? rows : remaining);
+}
+
+/*
+ * # of rows of a block whose colors are written to their mirror rows as well
+ */
+static int mirrored_rows(mo_block_t *block, mo_opts_t *opts)
+{
+    if (opts->mirror == 0) return 0;
+
+    /* mirror rows of the block's rows */
+    int first = opts->mirror - (block->row + block->rows - 1);
+    int last = opts->mirror - block->row;
+
+    if (first < 0) first = 0;
+    if (last > opts->height - 1) last = opts->height - 1;
+
+    return (last >= first) ? opts->mirrored[last + 1] - opts->mirrored[first] : 0;
+}
+
+/*
+ * plan the static schedule: the cost of each row is estimated from a preview 
+ * of every MO_PREVIEWSTEP-th pixel of every MO_PREVIEWSTEP-th row with at most 
+ * MO_PREVIEWITER iterations. pixels reaching that maximum are assumed to take 
+ * all iterations, unless the periodicity check is likely to stop them early. 
+ * the rows are split into one contiguous chunk of about equal cost per slave 
+ * at the prefix sums closest to multiples of the mean cost
+ */
+static void plan_partition(int *partition, int slave_count, mo_scale_t *scale, 
+        mo_opts_t *opts)
+{
+    const int rows = (opts->height + MO_PREVIEWSTEP - 1)/MO_PREVIEWSTEP;
+    double *cost = (double *) malloc(rows*sizeof(*cost));
+    double total = 0, sum = 0, row_cost;
+    int chunk = 1;
+    mo_opts_t preview = *opts;
+
+    preview.max_iterations = (opts->max_iterations < MO_PREVIEWITER) 
+        ? opts->max_iterations 
+        : MO_PREVIEWITER;
+
+    /* without a preview, all rows are assumed to cost the same */
+    if (cost != NULL) {
+        #pragma omp parallel for schedule(dynamic) num_threads(opts->threads)
+        for (int i = 0; i < rows; ++i) {
+            int row = i*MO_PREVIEWSTEP + MO_PREVIEWSTEP/2;
+            int n;
+
+            if (row >= opts->height) row = opts->height - 1;
+
+            cost[i] = 0;
+
+            for (int col = MO_PREVIEWSTEP/2; col < opts->width; col += MO_PREVIEWSTEP) {
+                n = mandelbrot(col, row, scale, &preview);
+
+                if (n == preview.max_iterations && !opts->periodicity) {
+                    n = opts->max_iterations;
+                }
+
+                cost[i] += n + MO_PIXELCOST;
+            }
+        }
+    }
+
+    for (int row = 0; row < opts->height; ++row) {
+        total += (cost != NULL) ? cost[row/MO_PREVIEWSTEP] : 1;
+    }
+
+    partition[0] = 0;
+
+    for (int row = 0; row < opts->height; ++row) {
+        row_cost = (cost != NULL) ? cost[row/MO_PREVIEWSTEP] : 1;
+
+        /* cut before the row if the chunk is closer to the mean cost without it */
+        while (chunk < slave_count && sum + row_cost/2 >= total*chunk/slave_count) {
+            partition[chunk++] = row;
+        }
+
+        sum += row_cost;
+    }
+
+    /* chunks beyond the last cut are empty */
+    while (chunk < slave_count) {
+        partition[chunk++] = opts->height;
+    }
+
+    partition[slave_count] = opts->height;
+
+    free(cost);
+}
+
+/*
+ * walk through the whole block schedule. if `done` is not NULL, the pixels of 
+ * the blocks marked in it are added to `frame_pixels`. returns the # of blocks
+ */
+static int64_t schedule_blocks(unsigned char *done, int64_t *frame_pixels, mo_opts_t *opts)
+{
+    mo_sched_t sched = { 0, 0, 0, 0, 0 };
+    mo_block_t block;
+
+    while (next_block(&sched, &block, opts->workers, opts)) {
+        if (done != NULL && (done[block.index/8] & (1 << block.index % 8))) {
+            frame_pixels[block.frame] += (int64_t) block.cols*
+                (block.rows + mirrored_rows(&block, opts));
+        }
+    }
+
+    return sched.index;
+}
+
+/*
+ * read the # of processes the schedule of the checkpoint was planned for on 
+ * process 0 and broadcast it to all processes, so they size their buffers 
+ * for the same blocks. an empty checkpoint was created by a render killed 
+ * before it stored anything, which is resumed from its start
+ */
+static int read_checkpoint(int proc_id, mo_opts_t *opts)
+{
+    mo_checkpoint_t checkpoint;
+    int workers = -1;
+    size_t length;
+    FILE *file;
+
+    if (proc_id == 0) {
+        if ((file = fopen(opts->checkpoint, "rb")) == NULL) {
+            eprintf("unable to open checkpoint '%s'.\n", opts->checkpoint);
+        } else {
+            length = fread(&checkpoint, 1, sizeof(checkpoint), file);
+
+            if (length == 0 && !ferror(file)) {
+                workers = opts->workers;
+            } else if (length == sizeof(checkpoint) && 
+                    memcmp(checkpoint.magic, "MOCP", 4) == 0 && checkpoint.workers > 0) {
+                workers = checkpoint.workers;
+            } else {
+                eprintf("invalid checkpoint '%s'.\n", opts->checkpoint);
+            }
+
+            fclose(file);
+        }
+    }
+
+    MPI_Bcast(&workers, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (workers == -1) return EXIT_FAILURE;
+
+    opts->workers = workers;
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * fill in the header of checkpoints of this render
+ */
+static void init_checkpoint(mo_checkpoint_t *checkpoint, int64_t block_count, 
+        mo_opts_t *opts)
+{
+    /* headers are compared bytewise, so the padding has to be zero as well */
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    memcpy(checkpoint->magic, "MOCP", 4);
+
+    checkpoint->width = opts->width;
+    checkpoint->height = opts->height;
+    checkpoint->frame_count = opts->frame_count;
+    checkpoint->max_iterations = opts->max_iterations;
+    checkpoint->blocksize = opts->blocksize;
+    checkpoint->block_width = opts->block_width;
+    checkpoint->schedule = opts->schedule;
+    checkpoint->workers = opts->workers;
+    checkpoint->mirror = opts->mirror;
+    checkpoint->formula = opts->formula;
+    checkpoint->julia = opts->julia;
+    checkpoint->julia_re = opts->julia_re;
+    checkpoint->julia_im = opts->julia_im;
+    checkpoint->min_re = opts->min_re;
+    checkpoint->min_im = opts->min_im;
+    checkpoint->axis_length = opts->axis_length;
+    checkpoint->block_count = block_count;
+}
+
+/*
+ * read the blocks stored by an interrupted render into `done`. the header of 
+ * the checkpoint has to match the one of this render
+ */
+static int load_checkpoint(mo_checkpoint_t *checkpoint, unsigned char *done, 
+        mo_opts_t *opts)
+{
+    const size_t done_size = (checkpoint->block_count + 7)/8;
+    mo_checkpoint_t header;
+    int retval = EXIT_FAILURE;
+    FILE *file;
+
+    if ((file = fopen(opts->checkpoint, "rb")) == NULL) {
+        eprintf("unable to open checkpoint '%s'.\n", opts->checkpoint);
+        return EXIT_FAILURE;
+    }
+
+    /* nothing was stored by the render of an empty checkpoint */
+    if (fgetc(file) == EOF && !ferror(file)) {
+        fclose(file);
+        return EXIT_SUCCESS;
+    }
+
+    rewind(file);
+
+    if (fread(&header, sizeof(header), 1, file) != 1 || 
+            memcmp(&header, checkpoint, sizeof(header)) != 0) {
+        eprintf("checkpoint '%s' belongs to a different render.\n", opts->checkpoint);
+    } else if (fread(done, 1, done_size, file) != done_size) {
+        eprintf("unable to read checkpoint '%s'.\n", opts->checkpoint);
+    } else {
+        retval = EXIT_SUCCESS;
+    }
+
+    fclose(file);
+
+    return retval;
+}
+
+/*
+ * position of the pixel lattice index `index` within its cache tile
+ */
+static inline int lattice_offset(int64_t index)
+{
+    int offset = (int) (index % MO_CACHETILE);
+
+    return (offset < 0) ? offset + MO_CACHETILE : offset;
+}
+
+/*
+ * look up a block in the tile cache and write it to the bitmap if found. 
+ * entries computed with more iterations hold the block as well. returns 
+ * EXIT_FAILURE if the block has to be computed
+ */
+static int write_cached_block(mo_block_t *block, mo_cache_t *cache, mo_opts_t *opts)
+{
+    const int count = block->cols*block->rows;
+
+    if (cache_read(block, cache->iterations, NULL, cache->scale, opts) < opts->max_iterations) {
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        if (cache->iterations[i] > opts->max_iterations) {
+            cache->iterations[i] = opts->max_iterations;
+        }
+    }
+
+    color_block(cache->iterations, block, cache->lines, cache->scale, opts);
+
+    if (write_bitmap_block(cache->fd, cache->lines, block, opts) != EXIT_SUCCESS) {
+        cache->retval = EXIT_FAILURE;
+    }
+
+    cache->pixels += count;
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * create the directories of all levels of the tile pyramid and its DeepZoom 
+ * descriptor, whose levels are numbered from the single pixel up to the full 
+ * resolution. allocate the master's state of the pyramid
+ */
+static int init_pyramid(mo_pyramid_t *pyramid, int slave_count, mo_opts_t *opts)
+{
+    char filename[MO_PATHLEN];
+    int width, height;
+    FILE *file;
+
+    pyramid->offsets = (int64_t *) malloc((opts->tile_levels + 1)*sizeof(*pyramid->offsets));
+    pyramid->idle = (int *) malloc(slave_count*sizeof(*pyramid->idle));
+
+    if (pyramid->offsets == NULL || pyramid->idle == NULL) {
+        eprintf("unable to allocate memory for buffers.\n");
+        return EXIT_FAILURE;
+    }
+
+    pyramid->offsets[0] = 0;
+
+    for (int level = 0; level < opts->tile_levels; ++level) {
+        level_size(level, &width, &height, opts);
+        pyramid->offsets[level + 1] = pyramid->offsets[level] + 
+            (int64_t) ((width + MO_TILESIZE - 1)/MO_TILESIZE)*
+            ((height + MO_TILESIZE - 1)/MO_TILESIZE);
+    }
+
+    /* each tile of a coarser level is pending once */
+    pyramid->remaining = pyramid->offsets[opts->tile_levels];
+    pyramid->children = (unsigned char *) calloc(pyramid->remaining, 
+            sizeof(*pyramid->children));
+    pyramid->pending = (mo_block_t *) malloc((pyramid->remaining - pyramid->offsets[1] + 1)*
+            sizeof(*pyramid->pending));
+
+    if (pyramid->children == NULL || pyramid->pending == NULL) {
+        eprintf("unable to allocate memory for buffers.\n");
+        return EXIT_FAILURE;
+    }
+
+    snprintf(filename, sizeof(filename), "%s_files", opts->tiles);
+
+    if (mkdir(filename, 0755) != 0 && errno != EEXIST) {
+        eprintf("unable to create directory '%s'.\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    for (int level = 0; level < opts->tile_levels; ++level) {
+        snprintf(filename, sizeof(filename), "%s_files/%d", opts->tiles, level);
+
+        if (mkdir(filename, 0755) != 0 && errno != EEXIST) {
+            eprintf("unable to create directory '%s'.\n", filename);
+            return EXIT_FAILURE;
+        }
+    }
+
+    snprintf(filename, sizeof(filename), "%s.dzi", opts->tiles);
+
+    if ((file = fopen(filename, "w")) == NULL) {
+        eprintf("unable to open file '%s'.\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+        "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"bmp\" " \
+        "Overlap=\"0\" TileSize=\"%d\">\n" \
+        "  <Size Width=\"%d\" Height=\"%d\"/>\n" \
+        "</Image>\n", MO_TILESIZE, opts->width, opts->height);
+
+    if (fclose(file) != 0) {
+        eprintf("unable to write file '%s'.\n", filename);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * count a finished tile towards its parent in the next coarser level, which 
+ * is pending once all of its (up to 2x2) children are finished
+ */
+static void finish_tile(mo_block_t *block, mo_pyramid_t *pyramid, mo_opts_t *opts)
+{
+    const int level = block->level + 1;
+    const int col = block->col/MO_TILESIZE/2;
+    const int row = block->row/MO_TILESIZE/2;
+    int width, height, child_width, child_height, children;
+    int64_t index;
+    mo_block_t *parent;
+
+    --pyramid->remaining;
+
+    if (level == opts->tile_levels) return;
+
+    level_size(block->level, &child_width, &child_height, opts);
+    level_size(level, &width, &height, opts);
+
+    index = pyramid->offsets[level] + 
+        (int64_t) row*((width + MO_TILESIZE - 1)/MO_TILESIZE) + col;
+
+    /* tiles at the right and bottom border may have a single child per row/column */
+    children = ((2*col + 1)*MO_TILESIZE < child_width ? 2 : 1)*
+        ((2*row + 1)*MO_TILESIZE < child_height ? 2 : 1);
+
+    if (++pyramid->children[index] < children) return;
+
+    parent = pyramid->pending + pyramid->pending_count++;
+    parent->index = index;
+    parent->frame = 0;
+    parent->col = col*MO_TILESIZE;
+    parent->row = row*MO_TILESIZE;
+    parent->cols = (width - parent->col < MO_TILESIZE) ? width - parent->col : MO_TILESIZE;
+    parent->rows = (height - parent->row < MO_TILESIZE) ? height - parent->row : MO_TILESIZE;
+    parent->level = level;
+}
+
+/*
+ * assign the most recently completed pending tile to a slave without waiting 
+ * for completion, like queue_block(). returns the # of result messages
+ */
+static int queue_tile(int proc_id, mo_pyramid_t *pyramid, mo_block_t *block, 
+        MPI_Request *request)
+{
+    MPI_Wait(request, MPI_STATUS_IGNORE);
+
+    *block = pyramid->pending[--pyramid->pending_count];
+    MPI_Isend(block, sizeof(*block), MPI_BYTE, proc_id, MO_CALC, MPI_COMM_WORLD, request);
+
+    return 1;
+}
+
+/*
+ * width/height of a level of the tile pyramid, which is downsampled `level` 
+ * times from the full resolution
+ */
+static inline void level_size(int level, int *width, int *height, mo_opts_t *opts)
+{
+    *width = (int) (((int64_t) opts->width + ((int64_t) 1 << level) - 1) >> level);
+    *height = (int) (((int64_t) opts->height + ((int64_t) 1 << level) - 1) >> level);
+}
+
+/*
+ * filename of a tile of the pyramid, DeepZoom levels count up from the 
+ * single pixel
+ */
+static void tile_filename(char *buffer, mo_block_t *block, mo_opts_t *opts)
+{
+    snprintf(buffer, MO_PATHLEN, "%s_files/%d/%d_%d.bmp", opts->tiles, 
+            opts->tile_levels - 1 - block->level, block->col/MO_TILESIZE, 
+            block->row/MO_TILESIZE);
+}
+
+/*
+ * write bitmap lines of `line_size` bytes of a tile (bottom-up, like 
+ * color_block()) to the tile's bitmap file
+ */
+static int write_tile(mo_block_t *block, char *lines, int line_size, mo_opts_t *opts)
+{
+    const int tile_line_size = bitmap_line_size(block->cols);
+    char filename[MO_PATHLEN];
+    int retval = EXIT_SUCCESS;
+    int fd;
+
+    tile_filename(filename, block, opts);
+
+    if ((fd = open_bitmap(filename, block->cols, block->rows, 0)) == -1) return EXIT_FAILURE;
+
+    if (line_size == tile_line_size) {
+        retval = pwrite_all(fd, lines, (int64_t) line_size*block->rows, 54);
+    } else {
+        for (int i = 0; i < block->rows && retval == EXIT_SUCCESS; ++i) {
+            retval = pwrite_all(fd, lines + (size_t) line_size*i, 3*block->cols, 
+                    54 + (int64_t) tile_line_size*i);
+        }
+    }
+
+    if (close(fd) != 0) retval = EXIT_FAILURE;
+
+    if (retval != EXIT_SUCCESS) {
+        eprintf("unable to write file '%s'.\n", filename);
+    }
+
+    return retval;
+}
+
+/*
+ * build a tile of a coarser level of the pyramid from its finished children 
+ * in the level below: each pixel is the mean of the up to 2x2 pixels it 
+ * covers. `children` receives the pixels of the children (2*MO_TILESIZE 
+ * squared, top-down), `lines` the bitmap lines of the tile
+ */
+static int downsample_tile(mo_block_t *block, char *children, char *lines, mo_opts_t *opts)
+{
+    const size_t size = 2*MO_TILESIZE;
+    const int line_size = bitmap_line_size(block->cols);
+    char filename[MO_PATHLEN];
+    int width, height, child_line_size, sum, count;
+    unsigned char *pixel;
+    mo_block_t child;
+    char *line;
+    FILE *file;
+
+    level_size(block->level - 1, &width, &height, opts);
+
+    child.level = block->level - 1;
+
+    for (int i = 0; i < 4; ++i) {
+        child.col = 2*block->col + (i % 2)*MO_TILESIZE;
+        child.row = 2*block->row + (i / 2)*MO_TILESIZE;
+
+        if (child.col >= width || child.row >= height) continue;
+
+        child.cols = (width - child.col < MO_TILESIZE) ? width - child.col : MO_TILESIZE;
+        child.rows = (height - child.row < MO_TILESIZE) ? height - child.row : MO_TILESIZE;
+        child_line_size = bitmap_line_size(child.cols);
+
+        tile_filename(filename, &child, opts);
+
+        if ((file = fopen(filename, "rb")) == NULL) {
+            eprintf("unable to open file '%s'.\n", filename);
+            return EXIT_FAILURE;
+        }
+
+        for (int y = 0; y < child.rows; ++y) {
+            pixel = (unsigned char *) children + 
+                3*(size*((i / 2)*MO_TILESIZE + y) + (i % 2)*MO_TILESIZE);
+
+            if (fseek(file, 54 + (long) child_line_size*(child.rows - 1 - y), SEEK_SET) != 0 || 
+                    fread(pixel, 3, child.cols, file) != (size_t) child.cols) {
+                eprintf("unable to read file '%s'.\n", filename);
+                fclose(file);
+                return EXIT_FAILURE;
+            }
+        }
+
+        fclose(file);
+    }
+
+    /* pixels of the level below which are covered by the tile */
+    width -= 2*block->col;
+    height -= 2*block->row;
+
+    for (int y = 0; y < block->rows; ++y) {
+        line = lines + (size_t) line_size*(block->rows - 1 - y);
+
+        for (int x = 0; x < block->cols; ++x) {
+            for (int c = 0; c < 3; ++c) {
+                sum = 0;
+                count = 0;
+
+                for (int j = 2*y; j < 2*y + 2 && j < height; ++j) {
+                    for (int i = 2*x; i < 2*x + 2 && i < width; ++i) {
+                        pixel = (unsigned char *) children + 3*(size*j + i);
+                        sum += pixel[c];
+                        ++count;
+                    }
+                }
+
+                line[3*x + c] = (char) ((sum + count/2)/count);
+            }
+        }
+
+        memset(line + 3*block->cols, 0, line_size - 3*block->cols);
+    }
+
+    return write_tile(block, lines, line_size, opts);
+}
+
+/*
+ * slave process logic
+ */
+static int slave_proc(mo_opts_t *opts) 
+{
+    const int max_cols = (opts->block_width < opts->width) ? opts->block_width : opts->width;
+    const int64_t data_size = result_size(opts);
+    const size_t lines_size = (size_t) block_line_size(max_cols, opts)*opts->max_rows;
+
+    mo_block_t *blocks = (mo_block_t *) malloc(2*sizeof(*blocks));
+    char *data = (data_size <= INT_MAX) ? (char *) malloc(2*data_size*sizeof(*data)) : NULL;
+    int *iterations = (int *) malloc((size_t) max_cols*opts->max_rows*sizeof(*iterations));
+    char *lines = (opts->mpi_io || opts->tiles != NULL) 
+        ? (char *) calloc(2*lines_size, sizeof(*lines)) 
+        : NULL;
+    char *children = (opts->tiles != NULL) 
+        ? (char *) malloc((size_t) 12*MO_TILESIZE*MO_TILESIZE*sizeof(*children)) 
+        : NULL;
+    MPI_Request *write_requests = opts->mpi_io 
+        ? (MPI_Request *) malloc(2*opts->max_rows*sizeof(*write_requests)) 
+        : NULL;
+    mo_scale_t *scale = (mo_scale_t *) malloc(sizeof(*scale));
+    mo_complex_t *z = (opts->cache_dir != NULL) 
+        ? (mo_complex_t *) malloc((size_t) max_cols*opts->max_rows*sizeof(*z)) 
+        : NULL;
+    int *grid = (opts->mode == MO_MODE_PROGRESSIVE) 
+        ? (int *) malloc((size_t) ((opts->width + 1)/2)*((opts->height + 1)/2)*sizeof(*grid)) 
+        : NULL;
+    int *halo = (opts->antialias > 1) 
+        ? (int *) malloc((size_t) (max_cols + 2)*(opts->max_rows + 2)*sizeof(*halo)) 
+        : NULL;
+    mo_sample_t *samples = (opts->antialias > 1) 
+        ? (mo_sample_t *) malloc((size_t) max_cols*opts->max_rows*sizeof(*samples)) 
+        : NULL;
+    int retval = EXIT_SUCCESS;
+    
+    if (blocks == NULL || data == NULL || iterations == NULL || scale == NULL || 
+            (opts->mpi_io && (lines == NULL || write_requests == NULL)) || 
+            (opts->tiles != NULL && (lines == NULL || children == NULL)) || 
+            (opts->cache_dir != NULL && z == NULL) || 
+            (opts->mode == MO_MODE_PROGRESSIVE && grid == NULL) || 
+            (opts->antialias > 1 && (halo == NULL || samples == NULL))) {
+        retval = EXIT_FAILURE;
+    }
+
+    const mo_kernel_t *kernel = pixel_kernel(opts);
+    mo_block_t *work, *block, piece;
+    mo_block_header_t *header;
+    int current_frame = 0;
+    int current_block = 0;
+    int current_buffer = 0;
+    int step = (opts->mode == MO_MODE_PROGRESSIVE) ? MO_PASSSTEP : 1;
+    int size;
+    double time;
+    
+    MPI_File fh;
+    MPI_Status status;
+    MPI_Request recv_request;
+    MPI_Request send_requests[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+
+    /* the bitmap file is opened by all processes together */
+    if (opts->mpi_io && open_bitmap_mpi(&fh, retval, 0, opts) != EXIT_SUCCESS) {
+        retval = EXIT_FAILURE;
+    }
+
+    if (retval != EXIT_SUCCESS) {
+        free(blocks); free(data); free(iterations); free(lines); free(children); 
+        free(write_requests); free(scale); free(z); free(grid); free(halo); free(samples);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; opts->mpi_io && i < 2*opts->max_rows; ++i) {
+        write_requests[i] = MPI_REQUEST_NULL;
+    }
+
+    init_scale(scale, opts);
+
+    MPI_Irecv(blocks, sizeof(*blocks), MPI_BYTE, 0, MPI_ANY_TAG, opts->comm, &recv_request);
+    time = begin_event(opts);
+
+    /* receive block and start computation if status is MO_CALC */
+    while ((MPI_Wait(&recv_request, &status) == MPI_SUCCESS) && 
+            (status.MPI_TAG == MO_CALC || status.MPI_TAG == MO_PASS)) {
+        end_event(MO_EV_RECV, time, NULL, NULL, opts);
+        work = blocks + current_block;
+
+        /* receive next block into the other buffer while this one is computed */
+        current_block ^= 1;
+        MPI_Irecv(blocks + current_block, sizeof(*blocks), MPI_BYTE, 0, MPI_ANY_TAG, 
+                opts->comm, &recv_request);
+
+        /* a pass of the progressive mode is complete, the master sends the 
+         * iteration counts of its pixels to guess those of the next pass */
+        if (status.MPI_TAG == MO_PASS) {
+            time = begin_event(opts);
+            MPI_Bcast(grid, ((opts->width + step - 1)/step)*((opts->height + step - 1)/step), 
+                    MPI_INT, 0, MPI_COMM_WORLD);
+            end_event(MO_EV_RECV, time, NULL, NULL, opts);
+
+            step /= 2;
+            time = begin_event(opts);
+            continue;
+        }
+
+        /* switch to the view of the block's frame */
+        if (work->frame != current_frame) {
+            current_frame = work->frame;
+            set_frame(current_frame, opts);
+            init_scale(scale, opts);
+            kernel = pixel_kernel(opts);
+        }
+
+        /* blocks of the static schedule may exceed the buffers, their results are
+         * sent in pieces of at most `max_rows` rows */
+        for (piece = *work; piece.row < work->row + work->rows; piece.row += piece.rows) {
+            block = &piece;
+            header = (mo_block_header_t *) (data + current_buffer*data_size);
+
+            block->rows = work->row + work->rows - block->row;
+
+            if (block->rows > opts->max_rows) block->rows = opts->max_rows;
+
+            /* make sure the result sent from this buffer two pieces ago is out */
+            time = begin_event(opts);
+            MPI_Wait(send_requests + current_buffer, MPI_STATUS_IGNORE);
+            end_event(MO_EV_SEND, time, NULL, NULL, opts);
+
+            header->block = *block;
+
+            time = begin_event(opts);
+
+            /* tiles of coarser levels of the pyramid are downsampled from their 
+             * children instead */
+            if (block->level > 0) {
+                header->encoding = (downsample_tile(block, children, lines, opts) == 
+                        EXIT_SUCCESS) ? MO_WRITTEN : MO_FAILED;
+                header->length = 0;
+                header->samples = 0;
+                end_event(MO_EV_WRITE, time, block, NULL, opts);
+
+                MPI_Isend(header, sizeof(*header), MPI_BYTE, 0, MO_DATA, opts->comm, 
+                        send_requests + current_buffer);
+
+                current_buffer ^= 1;
+                continue;
+            }
+
+            if (opts->cache_dir != NULL) {
+                compute_cached(block, iterations, z, scale, opts);
+            } else if (opts->mode == MO_MODE_MARIANI) {
+                compute_mariani(block, iterations, kernel, scale, opts);
+            } else if (opts->mode == MO_MODE_PROGRESSIVE) {
+                compute_progressive(block, iterations, grid, step, kernel, scale, opts);
+            } else {
+                compute_rows(block, iterations, kernel, scale, opts);
+            }
+
+            /* edges are refined once all pixels are computed */
+            header->samples = (opts->antialias > 1 && step == 1) 
+                ? antialias_block(block, iterations, halo, samples, kernel, scale, opts) 
+                : 0;
+
+            end_event(MO_EV_COMPUTE, time, block, iterations, opts);
+
+            if (opts->mpi_io) {
+                char *current_lines = lines + current_buffer*lines_size;
+                MPI_Request *current_requests = write_requests + current_buffer*opts->max_rows;
+
+                /* write colors of the block to the file and only report completion to the
+                 * master. the next block is computed while the lines are written */
+                time = begin_event(opts);
+                MPI_Waitall(opts->max_rows, current_requests, MPI_STATUSES_IGNORE);
+                end_event(MO_EV_WRITE, time, block, NULL, opts);
+
+                time = begin_event(opts);
+                color_block(iterations, block, current_lines, scale, opts);
+                apply_samples(current_lines, block, samples, header->samples, opts);
+                end_event(MO_EV_COLOR, time, block, NULL, opts);
+
+                time = begin_event(opts);
+                write_bitmap_block_mpi(fh, current_lines, block, current_requests, opts);
+                end_event(MO_EV_WRITE, time, block, NULL, opts);
+
+                header->encoding = MO_WRITTEN;
+                header->length = 0;
+                header->samples = 0;
+                size = sizeof(*header);
+            } else if (opts->tiles != NULL) {
+                /* tiles of the full resolution are written to their own files */
+                time = begin_event(opts);
+                color_block(iterations, block, lines, scale, opts);
+                apply_samples(lines, block, samples, header->samples, opts);
+                end_event(MO_EV_COLOR, time, block, NULL, opts);
+
+                time = begin_event(opts);
+                header->encoding = (write_tile(block, lines, block_line_size(block->cols, opts), 
+                        opts) == EXIT_SUCCESS) ? MO_WRITTEN : MO_FAILED;
+                end_event(MO_EV_WRITE, time, block, NULL, opts);
+
+                header->length = 0;
+                header->samples = 0;
+                size = sizeof(*header);
+            } else if (opts->node_buffers != NULL) {
+                size = store_shared(header, iterations, samples, opts);
+            } else {
+                size = encode_block(header, iterations, samples, opts);
+            }
+
+            /* send results to master and compute the next block while they are in transit */
+            MPI_Isend(header, size, MPI_BYTE, 0, MO_DATA, opts->comm, 
+                    send_requests + current_buffer);
+
+            current_buffer ^= 1;
+        }
+
+        time = begin_event(opts);
+    }
+
+    MPI_Waitall(2, send_requests, MPI_STATUSES_IGNORE);
+
+    if (opts->mpi_io) {
+        time = begin_event(opts);
+        MPI_Waitall(2*opts->max_rows, write_requests, MPI_STATUSES_IGNORE);
+        MPI_File_close(&fh);
+        end_event(MO_EV_WRITE, time, NULL, NULL, opts);
+    }
+
+    free(blocks);
+    free(data);
+    free(iterations);
+    free(lines);
+    free(children);
+    free(write_requests);
+    free(scale);
+    free(z);
+    free(grid);
+    free(halo);
+    free(samples);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * process logic of the processes of a node in the hierarchical schedule: the 
+ * leader allocates slots for the results of `depth` chunks in a window shared
+ * with the workers of its node, which compute like slaves of a master
+ */
+static int node_proc(mo_opts_t *opts)
+{
+    MPI_Aint size;
+    int rank, disp_unit, retval;
+    char *base;
+
+    MPI_Comm_rank(opts->node_comm, &rank);
+
+    size = (rank == 0) ? (MPI_Aint) opts->depth*result_size(opts) : 0;
+
+    MPI_Win_allocate_shared(size, 1, MPI_INFO_NULL, opts->node_comm, &base, &opts->node_win);
+    MPI_Win_shared_query(opts->node_win, 0, &size, &disp_unit, &base);
+    opts->node_buffers = base;
+
+    /* the window is accessed by plain loads and stores, which are ordered by 
+     * MPI_Win_sync and the messages between leader and workers */
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, opts->node_win);
+
+    retval = (rank == 0) ? leader_proc(opts) : slave_proc(opts);
+
+    MPI_Win_unlock_all(opts->node_win);
+    MPI_Win_free(&opts->node_win);
+    opts->node_buffers = NULL;
+
+    return retval;
+}
+
+/*
+ * process logic of a node leader: it is a slave of the master, whose blocks 
+ * (chunks) are split into blocks for the workers of the node by the guided 
+ * schedule. each worker has up to `depth` blocks queued, which are taken from
+ * the oldest chunk first. workers store their results in the chunk's slot of
+ * the shared window, once all of them are in, the slot is sent to the master
+ * as result of the chunk
+ */
+static int leader_proc(mo_opts_t *opts)
+{
+    const int64_t slot_size = result_size(opts);
+    int worker_count;
+
+    MPI_Comm_size(opts->node_comm, &worker_count);
+    --worker_count;
+
+    mo_chunk_t *chunks = (mo_chunk_t *) calloc(opts->depth, sizeof(*chunks));
+    int *samples = (int *) calloc((size_t) opts->depth*opts->max_rows, sizeof(*samples));
+    int *queued = (int *) calloc(worker_count + 1, sizeof(*queued));
+
+    if (chunks == NULL || samples == NULL || queued == NULL) {
+        eprintf("unable to allocate memory for chunks.\n");
+        free(chunks); free(samples); free(queued);
+        return EXIT_FAILURE;
+    }
+
+    mo_block_t work, block;
+    mo_block_header_t notice, *header;
+    mo_chunk_t *chunk;
+    int64_t remaining = 0;
+    int index, slot, next;
+    double time;
+
+    MPI_Status status;
+    MPI_Request requests[2];
+
+    for (int i = 0; i < opts->depth; ++i) {
+        chunks[i].samples = samples + (size_t) i*opts->max_rows;
+        chunks[i].request = MPI_REQUEST_NULL;
+    }
+
+    MPI_Irecv(&work, sizeof(work), MPI_BYTE, 0, MPI_ANY_TAG, opts->comm, requests);
+    MPI_Irecv(&notice, sizeof(notice), MPI_BYTE, MPI_ANY_SOURCE, MO_DATA, opts->node_comm, 
+            requests + 1);
+    time = begin_event(opts);
+
+    /* the master stops the leader once all of its chunks are finished */
+    while (MPI_Waitany(2, requests, &index, &status) == MPI_SUCCESS && 
+            (index == 1 || status.MPI_TAG == MO_CALC)) {
+        end_event(MO_EV_RECV, time, NULL, NULL, opts);
+
+        if (index == 0) {
+            /* the master never queues more than `depth` chunks */
+            for (slot = 0; chunks[slot].used; ++slot);
+
+            chunk = chunks + slot;
+            header = (mo_block_header_t *) (opts->node_buffers + (size_t) slot*slot_size);
+
+            MPI_Wait(&chunk->request, MPI_STATUS_IGNORE);
+
+            header->block = work;
+            header->encoding = MO_RAW;
+            header->length = work.cols*work.rows;
+            header->samples = 0;
+
+            chunk->used = 1;
+            chunk->row = work.row;
+            chunk->pending = 0;
+            remaining += work.rows;
+
+            MPI_Win_sync(opts->node_win);
+            MPI_Irecv(&work, sizeof(work), MPI_BYTE, 0, MPI_ANY_TAG, opts->comm, requests);
+        } else {
+            slot = notice.block.index;
+            chunk = chunks + slot;
+            header = (mo_block_header_t *) (opts->node_buffers + (size_t) slot*slot_size);
+
+            --queued[status.MPI_SOURCE];
+            --chunk->pending;
+            chunk->samples[notice.block.row - header->block.row] = notice.samples;
+
+            if (chunk->pending == 0 && chunk->row == header->block.row + header->block.rows) {
+                finish_chunk(header, chunk, opts);
+                chunk->used = 0;
+            }
+
+            MPI_Irecv(&notice, sizeof(notice), MPI_BYTE, MPI_ANY_SOURCE, MO_DATA, 
+                    opts->node_comm, requests + 1);
+        }
+
+        /* fill the queues of the workers evenly. blocks take half of the remaining
+         * rows of the node per round of blocks for all workers */
+        for (int d = 0; d < opts->depth; ++d) {
+            for (int w = 1; w <= worker_count; ++w) {
+                if (queued[w] > d) continue;
+
+                next = -1;
+
+                for (slot = 0; slot < opts->depth; ++slot) {
+                    header = (mo_block_header_t *) (opts->node_buffers + (size_t) slot*slot_size);
+
+                    if (chunks[slot].used && 
+                            chunks[slot].row < header->block.row + header->block.rows && 
+                            (next == -1 || header->block.index < block.index)) {
+                        next = slot;
+                        block = header->block;
+                    }
+                }
+
+                if (next == -1) break;
+
+                chunk = chunks + next;
+                header = (mo_block_header_t *) (opts->node_buffers + (size_t) next*slot_size);
+                block.index = next;
+                block.row = chunk->row;
+                block.rows = (int) ((remaining + 2*worker_count - 1)/(2*worker_count));
+
+                if (block.rows < opts->blocksize) block.rows = opts->blocksize;
+
+                if (block.rows > header->block.row + header->block.rows - chunk->row) {
+                    block.rows = header->block.row + header->block.rows - chunk->row;
+                }
+
+                chunk->row += block.rows;
+                ++chunk->pending;
+                ++queued[w];
+                remaining -= block.rows;
+
+                /* blocks are small, so the send doesn't wait for the worker */
+                MPI_Send(&block, sizeof(block), MPI_BYTE, w, MO_CALC, opts->node_comm);
+            }
+        }
+
+        time = begin_event(opts);
+    }
+
+    for (int w = 1; w <= worker_count; ++w) {
+        MPI_Send(NULL, 0, MPI_INT, w, MO_STOP, opts->node_comm);
+    }
+
+    MPI_Cancel(requests + 1);
+    MPI_Wait(requests + 1, MPI_STATUS_IGNORE);
+
+    for (int i = 0; i < opts->depth; ++i) {
+        MPI_Wait(&chunks[i].request, MPI_STATUS_IGNORE);
+    }
+
+    free(chunks);
+    free(samples);
+    free(queued);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * compact the anti-aliased pixels of a finished chunk, which the workers 
+ * stored at the first pixel of their blocks, and send the chunk to the master
+ */
+static void finish_chunk(mo_block_header_t *header, mo_chunk_t *chunk, mo_opts_t *opts)
+{
+    mo_sample_t *samples = block_samples(header, opts);
+    int size;
+
+    MPI_Win_sync(opts->node_win);
+
+    for (int i = 0; i < header->block.rows; ++i) {
+        if (chunk->samples[i] > 0) {
+            memmove(samples + header->samples, samples + (size_t) i*header->block.cols, 
+                    chunk->samples[i]*sizeof(*samples));
+            header->samples += chunk->samples[i];
+            chunk->samples[i] = 0;
+        }
+    }
+
+    size = (header->samples > 0) 
+        ? (char *) (samples + header->samples) - (char *) header 
+        : (int) sizeof(*header) + header->length*opts->iteration_size;
+
+    MPI_Isend(header, size, MPI_BYTE, 0, MO_DATA, opts->comm, &chunk->request);
+}
+
+/*
+ * master-free process logic: all processes compute blocks. the index of the
+ * next block is a shared counter in an RMA window on process 0, which is 
+ * claimed with MPI_Fetch_and_op. colors are written to the file with MPI-IO
+ */
+static int rma_proc(int proc_id, mo_opts_t *opts)
+{
+    const int max_cols = (opts->block_width < opts->width) ? opts->block_width : opts->width;
+    const size_t lines_size = (size_t) block_line_size(max_cols, opts)*opts->max_rows;
+
+    int *iterations = (int *) malloc((size_t) max_cols*opts->max_rows*sizeof(*iterations));
+    char *lines = (char *) calloc(2*lines_size, sizeof(*lines));
+    MPI_Request *write_requests = (MPI_Request *) malloc(2*opts->max_rows*
+            sizeof(*write_requests));
+    int *halo = (opts->antialias > 1) 
+        ? (int *) malloc((size_t) (max_cols + 2)*(opts->max_rows + 2)*sizeof(*halo)) 
+        : NULL;
+    mo_sample_t *samples = (opts->antialias > 1) 
+        ? (mo_sample_t *) malloc((size_t) max_cols*opts->max_rows*sizeof(*samples)) 
+        : NULL;
+    int retval = EXIT_SUCCESS;
+
+    if (iterations == NULL || lines == NULL || write_requests == NULL || 
+            (opts->antialias > 1 && (halo == NULL || samples == NULL))) {
+        eprintf("unable to allocate memory for buffers.\n");
+        retval = EXIT_FAILURE;
+    }
+
+    const mo_kernel_t *kernel = pixel_kernel(opts);
+    const int one = 1;
+    mo_sched_t sched = { 0, 0, 0, 0, 0 };
+    mo_block_t block;
+    mo_scale_t scale;
+    int *counter;
+    int index, next_index, count;
+    int block_index = -1;
+    int current_buffer = 0;
+    int64_t pixels_claimed = 0;
+    double start_time, end_time, time;
+
+    MPI_File fh;
+    MPI_Win win;
+
+    MPI_Win_allocate((proc_id == 0) ? sizeof(*counter) : 0, sizeof(*counter), MPI_INFO_NULL, 
+            MPI_COMM_WORLD, &counter, &win);
+
+    if (proc_id == 0) {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, win);
+        *counter = 0;
+        MPI_Win_unlock(0, win);
+    }
+
+    /* the bitmap file is opened by all processes together, which also makes
+     * sure the counter is initialized before it is accessed */
+    if (open_bitmap_mpi(&fh, retval, proc_id == 0, opts) != EXIT_SUCCESS) {
+        MPI_Win_free(&win);
+        free(iterations); free(lines); free(write_requests); free(halo); free(samples);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < 2*opts->max_rows; ++i) {
+        write_requests[i] = MPI_REQUEST_NULL;
+    }
+
+    init_scale(&scale, opts);
+
+    if (proc_id == 0) printf("Computation started.\n");
+
+    /* get start time */
+    start_time = MPI_Wtime();
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+    MPI_Fetch_and_op(&one, &next_index, MPI_INT, 0, 0, MPI_SUM, win);
+    MPI_Win_flush(0, win);
+
+    while (1) {
+        index = next_index;
+
+        /* the schedule is deterministic, so every process finds the block of
+         * a claimed index itself. claimed indices only grow */
+        while (block_index < index && next_block(&sched, &block, opts->workers, opts)) {
+            ++block_index;
+
+            /* only show progress if option set */
+            if (proc_id == 0 && opts->show_progress) {
+                pixels_claimed += (int64_t) block.cols*block.rows;
+                print_progress(pixels_claimed, (int64_t) opts->width*opts->height);
+            }
+        }
+
+        /* all blocks are claimed */
+        if (block_index < index) break;
+
+        /* claim the next block while this one is computed */
+        MPI_Fetch_and_op(&one, &next_index, MPI_INT, 0, 0, MPI_SUM, win);
+
+        time = begin_event(opts);
+
+        if (opts->mode == MO_MODE_MARIANI) {
+            compute_mariani(&block, iterations, kernel, &scale, opts);
+        } else {
+            compute_rows(&block, iterations, kernel, &scale, opts);
+        }
+
+        count = (opts->antialias > 1) 
+            ? antialias_block(&block, iterations, halo, samples, kernel, &scale, opts) 
+            : 0;
+
+        end_event(MO_EV_COMPUTE, time, &block, iterations, opts);
+
+        char *current_lines = lines + current_buffer*lines_size;
+        MPI_Request *current_requests = write_requests + current_buffer*opts->max_rows;
+
+        /* the next block is computed while the lines are written */
+        time = begin_event(opts);
+        MPI_Waitall(opts->max_rows, current_requests, MPI_STATUSES_IGNORE);
+        end_event(MO_EV_WRITE, time, &block, NULL, opts);
+
+        time = begin_event(opts);
+        color_block(iterations, &block, current_lines, &scale, opts);
+        apply_samples(current_lines, &block, samples, count, opts);
+        end_event(MO_EV_COLOR, time, &block, NULL, opts);
+
+        time = begin_event(opts);
+        write_bitmap_block_mpi(fh, current_lines, &block, current_requests, opts);
+        end_event(MO_EV_WRITE, time, &block, NULL, opts);
+
+        time = begin_event(opts);
+        MPI_Win_flush(0, win);
+        end_event(MO_EV_RECV, time, NULL, NULL, opts);
+
+        current_buffer ^= 1;
+    }
+
+    MPI_Win_unlock_all(win);
+
+    time = begin_event(opts);
+    MPI_Waitall(2*opts->max_rows, write_requests, MPI_STATUSES_IGNORE);
+    end_event(MO_EV_WRITE, time, NULL, NULL, opts);
+
+    /* wait for the other processes to finish their blocks */
+    time = begin_event(opts);
+    MPI_Barrier(MPI_COMM_WORLD);
+    end_event(MO_EV_RECV, time, NULL, NULL, opts);
+
+    /* get end time  */
+    end_time = MPI_Wtime();
+    opts->stats.seconds = end_time - start_time;
+
+    if (MPI_File_close(&fh) != MPI_SUCCESS) {
+        retval = EXIT_FAILURE;
+    }
+
+    MPI_Win_free(&win);
+
+    if (proc_id == 0) {
+        /* clear progress bar from stdout */
+        if (opts->show_progress) printf("\033[K");
+
+        printf("Finished. Computation finished in %g sec.\n\n", end_time - start_time);
+
+        if (retval == EXIT_SUCCESS) {
+            printf("Finished. Image stored in '%s'.\n", opts->filename);
+        } else {
+            eprintf("failed to write bitmap to file.\n");
+        }
+    }
+
+    free(iterations);
+    free(lines);
+    free(write_requests);
+    free(halo);
+    free(samples);
+
+    return retval;
+}
+
+/*
+ * compute iteration counts of a block row by row
+ */
+static void compute_rows(mo_block_t *block, int *iterations, const mo_kernel_t *kernel, 
+        mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int chunks = (block->cols + MO_CHUNKSIZE - 1)/MO_CHUNKSIZE;
+
+    /* split rows into chunks which are handed out to the threads dynamically, 
+     * so chunks near the set boundary don't hold up the others */
+    #pragma omp parallel for schedule(dynamic) num_threads(opts->threads)
+    for (int k = 0; k < block->rows*chunks; ++k) {
+        int i = k/chunks;
+        int col = (k % chunks)*MO_CHUNKSIZE;
+        int count = (col + MO_CHUNKSIZE < block->cols) ? MO_CHUNKSIZE : block->cols - col;
+
+        kernel->fn(block->row + i, block->col + col, count, scale, opts, 
+                iterations + block->cols*i + col);
+    }
+}
+
+/*
+ * compute iteration counts of a block using mariani-silver subdivision. only 
+ * the border of the block is computed upfront
+ */
+static void compute_mariani(mo_block_t *block, int *iterations, const mo_kernel_t *kernel, 
+        mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int cols = block->cols, rows = block->rows;
+
+    #pragma omp parallel num_threads(opts->threads)
+    #pragma omp single
+    {
+        kernel->fn(block->row, block->col, cols, scale, opts, iterations);
+
+        if (rows > 1) {
+            kernel->fn(block->row + rows - 1, block->col, cols, scale, opts, 
+                    iterations + cols*(rows - 1));
+        }
+
+        for (int j = 1; j < rows - 1; ++j) {
+            iterations[cols*j] = mandelbrot(block->col, block->row + j, scale, opts);
+            iterations[cols*j + cols - 1] = mandelbrot(block->col + cols - 1, block->row + j, 
+                    scale, opts);
+        }
+
+        mariani_silver(0, 0, cols, rows, block, iterations, kernel, scale, opts);
+    }
+}
+
+/*
+ * mariani-silver subdivision of the rectangle (x, y, w, h) of a block, whose 
+ * border is already computed. since the set is connected, the interior is 
+ * filled with the border's iteration count if all border pixels share it. 
+ * otherwise the rectangle is split into four, which are handed out to the 
+ * threads as tasks and processed the same way
+ */
+static void mariani_silver(int x, int y, int w, int h, mo_block_t *block, int *iterations, 
+        const mo_kernel_t *kernel, mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int cols = block->cols;
+    const int col = block->col + x, row = block->row + y;
+    int *top = iterations + cols*y + x;
+    int *bottom = top + cols*(h - 1);
+    int n = top[0];
+    int uniform = 1;
+
+    /* rectangle without interior */
+    if (w <= 2 || h <= 2) return;
+
+    for (int i = 0; i < w && uniform; ++i) {
+        uniform = (top[i] == n && bottom[i] == n);
+    }
+
+    for (int j = 1; j < h - 1 && uniform; ++j) {
+        uniform = (top[cols*j] == n && top[cols*j + w - 1] == n);
+    }
+
+    if (uniform) {
+        for (int j = 1; j < h - 1; ++j) {
+            for (int i = 1; i < w - 1; ++i) {
+                top[cols*j + i] = n;
+            }
+        }
+        return;
+    }
+
+    /* not worth subdividing any further */
+    if (w <= MO_MSMINSIZE || h <= MO_MSMINSIZE) {
+        for (int j = 1; j < h - 1; ++j) {
+            kernel->fn(row + j, col + 1, w - 2, scale, opts, top + cols*j + 1);
+        }
+        return;
+    }
+
+    /* compute the lines splitting the rectangle into four */
+    int mx = w/2, my = h/2;
+
+    kernel->fn(row + my, col + 1, w - 2, scale, opts, top + cols*my + 1);
+
+    for (int j = 1; j < h - 1; ++j) {
+        if (j != my) top[cols*j + mx] = mandelbrot(col + mx, row + j, scale, opts);
+    }
+
+    #pragma omp task if (w*h > MO_MSTASKSIZE)
+    mariani_silver(x, y, mx + 1, my + 1, block, iterations, kernel, scale, opts);
+    #pragma omp task if (w*h > MO_MSTASKSIZE)
+    mariani_silver(x + mx, y, w - mx, my + 1, block, iterations, kernel, scale, opts);
+    #pragma omp task if (w*h > MO_MSTASKSIZE)
+    mariani_silver(x, y + my, mx + 1, h - my, block, iterations, kernel, scale, opts);
+    #pragma omp task if (w*h > MO_MSTASKSIZE)
+    mariani_silver(x + mx, y + my, w - mx, h - my, block, iterations, kernel, scale, opts);
+}
+
+/*
+ * compute iteration counts of a block of a pass of the progressive mode. the 
+ * block's columns/rows refer to the grid of every `step`-th pixel of every 
+ * `step`-th row. pixels of the previous pass are copied from its grid, those 
+ * in between are guessed if possible. the remaining pixels are computed, in 
+ * the last pass runs of them by the row kernel
+ */
+static void compute_progressive(mo_block_t *block, int *iterations, int *grid, int step, 
+        const mo_kernel_t *kernel, mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int grid_width = (opts->width + 2*step - 1)/(2*step);
+    const int grid_height = (opts->height + 2*step - 1)/(2*step);
+
+    #pragma omp parallel for schedule(dynamic) num_threads(opts->threads)
+    for (int j = 0; j < block->rows; ++j) {
+        int *values = iterations + block->cols*j;
+        int row = block->row + j;
+        int i, count;
+
+        /* the first pass has no previous one to guess from */
+        for (i = 0; i < block->cols; ++i) {
+            values[i] = (step < MO_PASSSTEP) 
+                ? guess_pixel(block->col + i, row, grid, grid_width, grid_height) 
+                : -1;
+        }
+
+        for (i = 0; i < block->cols; i += count) {
+            for (count = 0; i + count < block->cols && values[i + count] < 0; ++count);
+
+            if (step == 1 && count > 1) {
+                kernel->fn(row, block->col + i, count, scale, opts, values + i);
+            } else if (count > 0) {
+                for (int k = 0; k < count; ++k) {
+                    values[i + k] = mandelbrot((block->col + i + k)*step, row*step, scale, 
+                            opts);
+                }
+            } else {
+                count = 1;
+            }
+        }
+    }
+}
+
+/*
+ * iteration count of pixel (col, row) of a pass of the progressive mode taken 
+ * from the grid of the previous pass, which holds every other pixel of every 
+ * other row. pixels between those of the previous pass get their count if 
+ * all of them agree. returns -1 if the pixel has to be computed
+ */
+static inline int guess_pixel(int col, int row, int *grid, int grid_width, int grid_height)
+{
+    const int x = col/2, y = row/2;
+    const int *top = grid + (size_t) grid_width*y + x;
+    const int n = top[0];
+
+    /* pixels at the right/bottom border have no neighbor on one side */
+    if ((col % 2 && x + 1 >= grid_width) || (row % 2 && y + 1 >= grid_height)) {
+        return -1;
+    }
+
+    if ((col % 2 && top[1] != n) || (row % 2 && top[grid_width] != n) || 
+            (col % 2 && row % 2 && top[grid_width + 1] != n)) {
+        return -1;
+    }
+
+    return n;
+}
+
+/*
+ * compute iteration counts of a block and store them in the tile cache. if 
+ * the cache holds the block with fewer iterations, pixels which did not 
+ * diverge continue from their final z instead of starting over
+ */
+static void compute_cached(mo_block_t *block, int *iterations, mo_complex_t *z, 
+        mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int count = block->cols*block->rows;
+    const int resumed = cache_read(block, iterations, z, scale, opts);
+
+    /* entries computed with more iterations only need to be capped */
+    if (resumed >= opts->max_iterations) {
+        for (int i = 0; i < count; ++i) {
+            if (iterations[i] > opts->max_iterations) iterations[i] = opts->max_iterations;
+        }
+        return;
+    }
+
+    #pragma omp parallel for schedule(dynamic, MO_CHUNKSIZE) num_threads(opts->threads)
+    for (int i = 0; i < count; ++i) {
+        if (resumed == -1) {
+            iterations[i] = 0;
+            z[i].re = z[i].im = 0;
+        } else if (isnan(z[i].re)) {
+            /* known to never diverge */
+            iterations[i] = opts->max_iterations;
+            continue;
+        }
+
+        iterations[i] = mandelbrot_resume(block->col + i % block->cols, 
+                block->row + i / block->cols, iterations[i], z + i, scale, opts);
+    }
+
+    /* the cache is an optimization only, so failing to write it is ignored */
+    cache_write(block, iterations, z, scale, opts);
+
+    /* pixels of the entry may have been iterated beyond the maximum */
+    for (int i = 0; i < count; ++i) {
+        if (iterations[i] > opts->max_iterations) iterations[i] = opts->max_iterations;
+    }
+}
+
+/*
+ * filename of the cache entry of the tile containing the block and position 
+ * of the block within the tile. entries are named after the pixel spacing and 
+ * the tile's position on the pixel lattice, so any view of the same zoom 
+ * level finds them
+ */
+static void cache_filename(char *buffer, mo_block_t *block, int *col, int *row, 
+        mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int64_t x = opts->lattice_col + block->col;
+    const int64_t y = opts->lattice_row + block->row;
+    uint64_t spacing_re, spacing_im;
+
+    memcpy(&spacing_re, &scale->re, sizeof(spacing_re));
+    memcpy(&spacing_im, &scale->im, sizeof(spacing_im));
+
+    *col = lattice_offset(x);
+    *row = lattice_offset(y);
+
+    snprintf(buffer, MO_PATHLEN, "%s/%016" PRIx64 "-%016" PRIx64 "-%" PRId64 "-%" PRId64 
+            ".tile", opts->cache_dir, spacing_re, spacing_im, (x - *col)/MO_CACHETILE, 
+            (y - *row)/MO_CACHETILE);
+}
+
+/*
+ * read iteration counts and, unless `z` is NULL, final values of z of a block 
+ * from the tile cache. returns the iteration maximum of the entry or -1 if 
+ * the cache does not hold all pixels of the block
+ */
+static int cache_read(mo_block_t *block, int *iterations, mo_complex_t *z, 
+        mo_scale_t *scale, mo_opts_t *opts)
+{
+    const long z_offset = sizeof(mo_tile_header_t) + 
+        (long) MO_CACHETILE*MO_CACHETILE*sizeof(*iterations);
+    char filename[MO_PATHLEN];
+    mo_tile_header_t tile;
+    int col, row, retval = -1;
+    long offset;
+    FILE *file;
+
+    cache_filename(filename, block, &col, &row, scale, opts);
+
+    if ((file = fopen(filename, "rb")) == NULL) return -1;
+
+    if (fread(&tile, sizeof(tile), 1, file) == 1 && memcmp(tile.magic, "MOTC", 4) == 0 && 
+            tile.version == MO_CACHEVERSION) {
+        retval = tile.max_iterations;
+    }
+
+    for (int i = 0; retval != -1 && i < block->rows; ++i) {
+        offset = (long) (row + i)*MO_CACHETILE + col;
+
+        if (fseek(file, sizeof(tile) + offset*sizeof(*iterations), SEEK_SET) != 0 || 
+                fread(iterations + block->cols*i, sizeof(*iterations), block->cols, file) != 
+                (size_t) block->cols) {
+            retval = -1;
+        } else if (z != NULL && (fseek(file, z_offset + offset*sizeof(*z), SEEK_SET) != 0 || 
+                fread(z + block->cols*i, sizeof(*z), block->cols, file) != 
+                (size_t) block->cols)) {
+            retval = -1;
+        }
+
+        /* pixels of the tile which were never computed are -1 */
+        for (int j = 0; retval != -1 && j < block->cols; ++j) {
+            if (iterations[block->cols*i + j] < 0) retval = -1;
+        }
+    }
+
+    fclose(file);
+
+    return retval;
+}
+
+/*
+ * merge iteration counts and final values of z of a block into its entry in 
+ * the tile cache. pixels of the entry outside of the block are kept, pixels of 
+ * the block replace those of the entry unless the entry's are iterated 
+ * further. the entry is written to a temporary file first and renamed, so 
+ * concurrent renders never read incomplete entries
+ */
+static int cache_write(mo_block_t *block, int *iterations, mo_complex_t *z, 
+        mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int count = MO_CACHETILE*MO_CACHETILE;
+    char filename[MO_PATHLEN], tmp_filename[MO_PATHLEN + 32];
+    mo_tile_header_t tile = { "MOTC", MO_CACHEVERSION, INT_MAX };
+    int *tile_iterations = (int *) malloc(count*sizeof(*tile_iterations));
+    mo_complex_t *tile_z = (mo_complex_t *) malloc(count*sizeof(*tile_z));
+    int col, row, retval = EXIT_FAILURE;
+    FILE *file;
+
+    cache_filename(filename, block, &col, &row, scale, opts);
+    snprintf(tmp_filename, sizeof(tmp_filename), "%s.%ld", filename, (long) getpid());
+
+    if (tile_iterations == NULL || tile_z == NULL) {
+        free(tile_iterations);
+        free(tile_z);
+        return EXIT_FAILURE;
+    }
+
+    if (!read_tile(filename, tile_iterations, tile_z)) {
+        for (int i = 0; i < count; ++i) {
+            tile_iterations[i] = -1;
+            tile_z[i].re = tile_z[i].im = 0;
+        }
+    }
+
+    for (int i = 0; i < block->rows; ++i) {
+        for (int j = 0; j < block->cols; ++j) {
+            const int k = (row + i)*MO_CACHETILE + col + j, l = block->cols*i + j;
+
+            /* pixels known to never diverge stay done, others keep the state 
+             * of the most iterations */
+            if (tile_iterations[k] < 0 || isnan(z[l].re) || 
+                    (!isnan(tile_z[k].re) && iterations[l] >= tile_iterations[k])) {
+                tile_iterations[k] = isnan(z[l].re) ? INT_MAX : iterations[l];
+                tile_z[k] = z[l];
+            }
+        }
+    }
+
+    /* the entry holds the final state of all pixels for iteration maxima up to
+     * the lowest count of a pixel which is still iterated */
+    for (int i = 0; i < count; ++i) {
+        if (tile_iterations[i] >= 0 && tile_iterations[i] < tile.max_iterations && 
+                !isnan(tile_z[i].re) && 
+                tile_z[i].re*tile_z[i].re + tile_z[i].im*tile_z[i].im < MO_THRESHOLD) {
+            tile.max_iterations = tile_iterations[i];
+        }
+    }
+
+    if ((file = fopen(tmp_filename, "wb")) != NULL) {
+        if (fwrite(&tile, sizeof(tile), 1, file) == 1 && 
+                fwrite(tile_iterations, sizeof(*tile_iterations), count, file) == (size_t) count && 
+                fwrite(tile_z, sizeof(*tile_z), count, file) == (size_t) count) {
+            retval = EXIT_SUCCESS;
+        }
+
+        if (fclose(file) != 0) retval = EXIT_FAILURE;
+
+        if (retval != EXIT_SUCCESS || rename(tmp_filename, filename) != 0) {
+            unlink(tmp_filename);
+            retval = EXIT_FAILURE;
+        }
+    }
+
+    free(tile_iterations);
+    free(tile_z);
+
+    return retval;
+}
+
+/*
+ * read all iteration counts and final values of z of a tile cache entry. 
+ * returns 1 if the entry exists and is complete
+ */
+static int read_tile(const char *filename, int *iterations, mo_complex_t *z)
+{
+    const size_t count = MO_CACHETILE*MO_CACHETILE;
+    mo_tile_header_t tile;
+    int retval = 0;
+    FILE *file;
+
+    if ((file = fopen(filename, "rb")) == NULL) return 0;
+
+    if (fread(&tile, sizeof(tile), 1, file) == 1 && memcmp(tile.magic, "MOTC", 4) == 0 && 
+            tile.version == MO_CACHEVERSION && 
+            fread(iterations, sizeof(*iterations), count, file) == count && 
+            fread(z, sizeof(*z), count, file) == count) {
+        retval = 1;
+    }
+
+    fclose(file);
+
+    return retval;
+}
+
+/*
+ * encode iteration counts of the block described by header into the message
+ * following the header. values are stored in the narrowest type that holds 
+ * max_iterations. if compression is enabled, the block is run-length encoded 
+ * as (run, iterations) pairs unless that is larger than the raw block. the 
+ * header's anti-aliased pixels are appended. returns the size of the message 
+ * in bytes
+ */
+static int encode_block(mo_block_header_t *header, int *iterations, mo_sample_t *samples, 
+        mo_opts_t *opts)
+{
+    void *values = header + 1;
+    const int count = header->block.cols*header->block.rows;
+    const int max_run = (opts->iteration_size == 2) ? 0xffff : 0x7fffffff;
+    int i = 0, run;
+
+    header->length = 0;
+
+    if (opts->compress) {
+        header->encoding = MO_RLE;
+
+        for (; i < count && header->length + 2 <= count; i += run) {
+            for (run = 1; i + run < count && run < max_run && 
+                iterations[i + run] == iterations[i]; ++run);
+
+            set_value(values, header->length++, run, opts->iteration_size);
+            set_value(values, header->length++, iterations[i], opts->iteration_size);
+        }
+    }
+
+    /* fall back to raw encoding if the runs didn't pay off */
+    if (i < count) {
+        header->encoding = MO_RAW;
+        header->length = count;
+
+        for (i = 0; i < count; ++i) {
+            set_value(values, i, iterations[i], opts->iteration_size);
+        }
+    }
+
+    /* anti-aliased pixels follow the values */
+    if (header->samples > 0) {
+        memcpy(block_samples(header, opts), samples, header->samples*sizeof(*samples));
+
+        return (char *) (block_samples(header, opts) + header->samples) - (char *) header;
+    }
+
+    return sizeof(*header) + header->length*opts->iteration_size;
+}
+
+/*
+ * store iteration counts and anti-aliased pixels of a block of a worker right 
+ * in the result of its chunk in the node leader's shared window. the block's
+ * index is the slot of the chunk. values are at their final position, samples
+ * are stored at the position of the block's first pixel and compacted by the
+ * leader. only the header is sent to the leader, returns its size in bytes
+ */
+static int store_shared(mo_block_header_t *header, int *iterations, mo_sample_t *samples, 
+        mo_opts_t *opts)
+{
+    mo_block_header_t *chunk = (mo_block_header_t *) (opts->node_buffers + 
+            (size_t) header->block.index*result_size(opts));
+    const int count = header->block.cols*header->block.rows;
+    void *values = chunk + 1;
+    int offset;
+
+    /* the leader stored the chunk's header before it handed out the block */
+    MPI_Win_sync(opts->node_win);
+
+    offset = (header->block.row - chunk->block.row)*chunk->block.cols;
+
+    for (int i = 0; i < count; ++i) {
+        set_value(values, offset + i, iterations[i], opts->iteration_size);
+    }
+
+    mo_sample_t *shared = block_samples(chunk, opts) + offset;
+
+    for (int i = 0; i < header->samples; ++i) {
+        shared[i].index = samples[i].index + offset;
+        shared[i].color = samples[i].color;
+    }
+
+    /* the leader sees the stores once it receives the header */
+    MPI_Win_sync(opts->node_win);
+
+    header->encoding = MO_RAW;
+    header->length = 0;
+
+    return sizeof(*header);
+}
+
+/*
+ * decode iteration counts of a received block, scale them to colors and 
+ * store them as bitmap lines. since bitmaps are stored bottom-up, the last
+ * row of the block is stored first
+ */
+static void decode_block(mo_block_header_t *header, char *lines, mo_scale_t *scale, 
+        mo_opts_t *opts)
+{
+    const int cols = header->block.cols;
+    const size_t line_size = block_line_size(cols, opts);
+    void *values = header + 1;
+    char *line = lines + line_size*(header->block.rows - 1);
+    long color;
+    int n, run;
+    int col = 0;
+
+    for (int i = 0; i < header->length; ++i) {
+        if (header->encoding == MO_RLE) {
+            run = get_value(values, i++, opts->iteration_size);
+        } else {
+            run = 1;
+        }
+
+        n = get_value(values, i, opts->iteration_size);
+        color = pixel_color(n, scale, opts) & opts->color_mask;
+
+        for (; run > 0; --run) {
+            set_pixel(line, col, color);
+
+            /* continue with the next row of the block */
+            if (++col == cols) {
+                line -= line_size;
+                col = 0;
+            }
+        }
+    }
+
+    apply_samples(lines, &header->block, block_samples(header, opts), header->samples, opts);
+}
+
+/*
+ * decode iteration counts of a received block of a pass of the progressive 
+ * mode into the grid of the pass, which is `grid_width` pixels wide
+ */
+static void decode_grid(mo_block_header_t *header, int *grid, int grid_width, mo_opts_t *opts)
+{
+    void *values = header + 1;
+    int *row = grid + (size_t) grid_width*header->block.row + header->block.col;
+    int n, run;
+    int col = 0;
+
+    for (int i = 0; i < header->length; ++i) {
+        if (header->encoding == MO_RLE) {
+            run = get_value(values, i++, opts->iteration_size);
+        } else {
+            run = 1;
+        }
+
+        n = get_value(values, i, opts->iteration_size);
+
+        for (; run > 0; --run) {
+            row[col] = n;
+
+            /* continue with the next row of the block */
+            if (++col == header->block.cols) {
+                row += grid_width;
+                col = 0;
+            }
+        }
+    }
+}
+
+/*
+ * store the preview of a pass of the progressive mode in the bitmap: each 
+ * pixel of the grid of the pass is stretched to `step` x `step` pixels. the 
+ * image is written in blocks of the size of the line buffer
+ */
+static int write_preview(int fd, int *grid, int step, char *lines, mo_scale_t *scale, 
+        mo_opts_t *opts)
+{
+    const int grid_width = (opts->width + step - 1)/step;
+    const int max_cols = (opts->block_width < opts->width) ? opts->block_width : opts->width;
+    mo_block_t block = { 0, 0, 0, 0, 0, 0, 0 };
+    int retval = EXIT_SUCCESS;
+    size_t line_size;
+    int *values;
+    char *line;
+
+    for (block.row = 0; block.row < opts->height && retval == EXIT_SUCCESS; 
+            block.row += block.rows) {
+        block.rows = (opts->height - block.row < opts->max_rows) 
+            ? opts->height - block.row 
+            : opts->max_rows;
+
+        for (block.col = 0; block.col < opts->width && retval == EXIT_SUCCESS; 
+                block.col += block.cols) {
+            block.cols = (opts->width - block.col < max_cols) ? opts->width - block.col : max_cols;
+            line_size = block_line_size(block.cols, opts);
+
+            for (int i = 0; i < block.rows; ++i) {
+                values = grid + (size_t) grid_width*((block.row + i)/step);
+                line = lines + line_size*(block.rows - 1 - i);
+
+                for (int col = 0; col < block.cols; ++col) {
+                    set_pixel(line, col, pixel_color(values[(block.col + col)/step], scale, 
+                                opts) & opts->color_mask);
+                }
+            }
+
+            retval = write_bitmap_block(fd, lines, &block, opts);
+        }
+    }
+
+    return retval;
+}
+
+/*
+ * scale iteration counts of a block to colors and store them as bitmap lines 
+ * (bottom-up, like decode_block())
+ */
+static void color_block(int *iterations, mo_block_t *block, char *lines, mo_scale_t *scale, 
+        mo_opts_t *opts)
+{
+    const size_t line_size = block_line_size(block->cols, opts);
+    char *line;
+
+    for (int i = 0; i < block->rows; ++i) {
+        line = lines + line_size*(block->rows - 1 - i);
+
+        for (int col = 0; col < block->cols; ++col) {
+            set_pixel(line, col, pixel_color(iterations[block->cols*i + col], scale, opts) & 
+                    opts->color_mask);
+        }
+    }
+}
+
+/*
+ * find the edge pixels of a computed block and anti-alias them: their color is
+ * the mean color of `antialias` x `antialias` samples spread evenly over the 
+ * pixel. `halo` receives the block with a border of the neighboring pixels, 
+ * which are computed once more. returns the # of anti-aliased pixels stored 
+ * in `samples`
+ */
+static int antialias_block(mo_block_t *block, int *iterations, int *halo, mo_sample_t *samples, 
+        const mo_kernel_t *kernel, mo_scale_t *scale, mo_opts_t *opts)
+{
+    const int cols = block->cols, rows = block->rows, width = cols + 2;
+    const int n = opts->antialias;
+    const int first = (block->col > 0) ? block->col - 1 : 0;
+    const int last = (block->col + cols < opts->width) ? block->col + cols : block->col + cols - 1;
+    mo_opts_t sub;
+    mo_scale_t sub_scale;
+    int *runs = halo;
+    int count = 0, run_count = 0;
+
+    /* neighbors outside of the image are -1 */
+    for (int i = 0; i < width*(rows + 2); ++i) {
+        halo[i] = -1;
+    }
+
+    for (int j = 0; j < rows; ++j) {
+        int *line = halo + width*(j + 1) + 1;
+
+        memcpy(line, iterations + cols*j, cols*sizeof(*line));
+
+        if (block->col > 0) {
+            line[-1] = mandelbrot(block->col - 1, block->row + j, scale, opts);
+        }
+
+        if (block->col + cols < opts->width) {
+            line[cols] = mandelbrot(block->col + cols, block->row + j, scale, opts);
+        }
+    }
+
+    if (block->row > 0) {
+        kernel->fn(block->row - 1, first, last - first + 1, scale, opts, 
+                halo + 1 + first - block->col);
+    }
+
+    if (block->row + rows < opts->height) {
+        kernel->fn(block->row + rows, first, last - first + 1, scale, opts, 
+                halo + width*(rows + 1) + 1 + first - block->col);
+    }
+
+    for (int j = 0; j < rows; ++j) {
+        for (int i = 0; i < cols; ++i) {
+            if (edge_pixel(halo + width*(j + 1) + i + 1, width)) {
+                samples[count++].index = cols*j + i;
+            }
+        }
+    }
+
+    /* neighboring edge pixels of a row are sampled together in runs of up to 
+     * MO_AARUN pixels. the halo is done with, it receives the first pixel of 
+     * each run followed by the end of the last one */
+    for (int k = 0; k < count; ++k) {
+        if (k == 0 || samples[k].index % cols == 0 || 
+                samples[k].index != samples[k - 1].index + 1 || 
+                k - runs[run_count - 1] == MO_AARUN) {
+            runs[run_count++] = k;
+        }
+    }
+
+    runs[run_count] = count;
+
+    init_samples(&sub, &sub_scale, opts);
+
+    const mo_kernel_t *sub_kernel = pixel_kernel(&sub);
+
+    #pragma omp parallel for schedule(dynamic) num_threads(opts->threads)
+    for (int r = 0; r < run_count; ++r) {
+        const int k = runs[r], run = runs[r + 1] - runs[r];
+        const int col = block->col + samples[k].index % cols;
+        const int row = block->row + samples[k].index / cols;
+        int values[MO_MAXANTIALIAS*MO_AARUN];
+        long color, red[MO_AARUN], green[MO_AARUN], blue[MO_AARUN];
+
+        for (int i = 0; i < run; ++i) {
+            red[i] = green[i] = blue[i] = 0;
+        }
+
+        for (int y = 0; y < n; ++y) {
+            if (opts->deep) {
+                for (int x = 0; x < n*run; ++x) {
+                    values[x] = mandelbrot(2*n*col + 2*x + 1 - n, 2*n*row + 2*y + n, 
+                            &sub_scale, &sub);
+                }
+            } else {
+                sub_kernel->fn(n*row + y, n*col, n*run, &sub_scale, &sub, values);
+            }
+
+            for (int x = 0; x < n*run; ++x) {
+                color = pixel_color(values[x], scale, opts) & opts->color_mask;
+                red[x/n] += (color >> 16) & 0xFF;
+                green[x/n] += (color >> 8) & 0xFF;
+                blue[x/n] += color & 0xFF;
+            }
+        }
+
+        for (int i = 0; i < run; ++i) {
+            samples[k + i].color = (int) ((red[i] + n*n/2)/(n*n) << 16 | 
+                    (green[i] + n*n/2)/(n*n) << 8 | (blue[i] + n*n/2)/(n*n));
+        }
+    }
+
+    return count;
+}
+
+/*
+ * settings of the samples of anti-aliased pixels
+ */
+static void init_samples(mo_opts_t *sub, mo_scale_t *sub_scale, mo_opts_t *opts)
+{
+    const int n = opts->antialias;
+
+    /* samples are pixels of an image n times the size, which is moved by a fraction 
+     * of a pixel so the n x n samples of a pixel are centered on it, and rows of 
+     * them are computed by the row kernel. they may need a higher precision than 
+     * the pixels. deep zooms can't be moved, they use an image 2n times the size */
+    *sub = *opts;
+    sub->width = (opts->deep ? 2*n : n)*opts->width;
+    sub->height = (opts->deep ? 2*n : n)*opts->height;
+
+    if (opts->select_precision && !opts->deep) {
+        sub->precision = auto_precision(sub);
+
+        if (sub->precision == MO_PREC_AUTO) sub->precision = MO_PREC_LONG;
+    }
+
+    init_scale(sub_scale, sub);
+
+    sub->min_re -= (n - 1)*sub_scale->re/2;
+    sub->min_im -= (n - 1)*sub_scale->im/2;
+    sub->min_re_long -= (n - 1)*sub_scale->re_long/2;
+    sub->min_im_long -= (n - 1)*sub_scale->im_long/2;
+}
+
+/*
+ * 1 if the iteration count of a pixel in the halo differs from one of its 
+ * neighbors by more than MO_AAEDGE of the larger one
+ */
+static inline int edge_pixel(int *pixel, int width)
+{
+    const int neighbors[4] = { pixel[-1], pixel[1], pixel[-width], pixel[width] };
+    const int n = pixel[0];
+
+    for (int i = 0; i < 4; ++i) {
+        int m = neighbors[i];
+
+        if (m >= 0 && abs(n - m) > MO_AAEDGE*((n > m) ? n : m)) return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * overwrite the colors of the anti-aliased pixels of a block in its bitmap lines
+ */
+static void apply_samples(char *lines, mo_block_t *block, mo_sample_t *samples, int count, 
+        mo_opts_t *opts)
+{
+    const size_t line_size = block_line_size(block->cols, opts);
+
+    for (int k = 0; k < count; ++k) {
+        set_pixel(lines + line_size*(block->rows - 1 - samples[k].index/block->cols), 
+                samples[k].index % block->cols, samples[k].color);
+    }
+}
+
+/*
+ * anti-aliased pixels of a result message, which follow the values aligned 
+ * to the size of the samples
+ */
+static inline mo_sample_t *block_samples(mo_block_header_t *header, mo_opts_t *opts)
+{
+    const size_t size = sizeof(mo_sample_t);
+
+    return (mo_sample_t *) ((char *) (header + 1) + 
+            (header->length*opts->iteration_size + size - 1)/size*size);
+}
+
+/*
+ * start time of an event, which is only taken if events are reported
+ */
+static inline double begin_event(mo_opts_t *opts)
+{
+    return opts->instrument ? MPI_Wtime() : 0;
+}
+
+/*
+ * end an event which started at `start` if events are reported. `block` is 
+ * NULL for waits, `iterations` holds the iteration counts of computed blocks 
+ * or is NULL
+ */
+static inline void end_event(int type, double start, mo_block_t *block, int *iterations, 
+        mo_opts_t *opts)
+{
+    if (opts->instrument) {
+        record_event(type, start, block, iterations, opts);
+    }
+}
+
+/*
+ * account the time since `start` to the phase of the event in the statistics 
+ * and record the event if tracing is enabled
+ */
+static void record_event(int type, double start, mo_block_t *block, int *iterations, 
+        mo_opts_t *opts)
+{
+    const double end = MPI_Wtime();
+    mo_trace_t *trace = opts->trace;
+    mo_event_t *event;
+    double sum = (iterations != NULL) ? count_iterations(iterations, block, opts) : 0;
+
+    switch (type) {
+        case MO_EV_COMPUTE:
+            opts->stats.compute += end - start;
+            break;
+        case MO_EV_RECV:
+        case MO_EV_SEND:
+            opts->stats.communication += end - start;
+            break;
+        case MO_EV_COLOR:
+        case MO_EV_DECODE:
+            opts->stats.color += end - start;
+            break;
+        default:
+            opts->stats.write += end - start;
+            break;
+    }
+
+    if (trace == NULL) return;
+
+    /* the event buffer grows by doubling */
+    if (trace->count == trace->size) {
+        int size = (trace->size > 0) ? 2*trace->size : MO_TRACESIZE;
+        mo_event_t *events = (mo_event_t *) realloc(trace->events, size*sizeof(*events));
+
+        if (events == NULL) {
+            ++trace->dropped;
+            return;
+        }
+
+        trace->events = events;
+        trace->size = size;
+    }
+
+    event = trace->events + trace->count++;
+    event->start = start - trace->origin;
+    event->end = end - trace->origin;
+    event->iterations = sum;
+    event->type = type;
+
+    if (block != NULL) {
+        event->block = *block;
+    } else {
+        memset(&event->block, 0, sizeof(event->block));
+        event->block.index = -1;
+    }
+}
+
+/*
+ * add the iteration counts of a computed block to the statistics. returns 
+ * the sum of the block's iteration counts
+ */
+static double count_iterations(int *iterations, mo_block_t *block, mo_opts_t *opts)
+{
+    const int count = block->cols*block->rows;
+    int64_t sum = 0;
+
+    for (int i = 0; i < count; ++i) {
+        sum += iterations[i];
+    }
+
+    opts->stats.iterations += (double) sum;
+    opts->stats.pixels += count;
+
+    return (double) sum;
+}
+
+/*
+ * length of the bitmap lines of a block with `cols` columns in the line buffers.
+ * lines of blocks spanning the whole image width include the padding, so they 
+ * can be written at once
+ */
+static inline int block_line_size(int cols, mo_opts_t *opts)
+{
+    return (cols == opts->width) ? bitmap_line_size(opts->width) : 3*cols;
+}
+
+/*
+ * size of the largest result message in bytes: the header, the values of a 
+ * block of `max_rows` rows and its anti-aliased pixels. it is rounded up to 
+ * the alignment of the samples, so messages can be stored back to back
+ */
+static inline int64_t result_size(mo_opts_t *opts)
+{
+    const int max_cols = (opts->block_width < opts->width) ? opts->block_width : opts->width;
+    const int64_t pixels = (int64_t) max_cols*opts->max_rows;
+    const int64_t size = sizeof(mo_block_header_t) + pixels*opts->iteration_size + 
+        ((opts->antialias > 1) ? (pixels + 1)*(int64_t) sizeof(mo_sample_t) : 0);
+
+    return (size + sizeof(mo_sample_t) - 1)/sizeof(mo_sample_t)*sizeof(mo_sample_t);
+}
+
+/*
+ * store color as pixel `col` of a bitmap line
+ */
+static inline void set_pixel(char *line, int col, long color)
+{
+    line[3*col] = (char) (color & 0xFF);
+    line[3*col + 1] = (char) ((color >> 8) & 0xFF);
+    line[3*col + 2] = (char) ((color >> 16) & 0xFF);
+}
+
+/*
+ * access values of the given size (2 or 4 bytes) in a result message
+ */
+static inline void set_value(void *values, int i, int value, int size)
+{
+    if (size == 2) {
+        ((uint16_t *) values)[i] = (uint16_t) value;
+    } else {
+        ((uint32_t *) values)[i] = (uint32_t) value;
+    }
+}
+
+static inline int get_value(void *values, int i, int size)
+{
+    return (size == 2) ? ((uint16_t *) values)[i] : (int) ((uint32_t *) values)[i];
+}
+
+/*
+ * one iteration z = z^power + c of the formula of `power` and `ship` in 
+ * precision `type`, which may be a vector type. `abs` is the absolute value
+ * function of the type. the square is expanded into its real and imaginary 
+ * part, higher powers are computed by repeated multiplication. the scalar and 
+ * vectorized kernels perform the same operations in the same order, so their
+ * results are bit-identical
+ */
+#define MO_STEP(type, power, ship, abs, z_re, z_im, c_re, c_im) \
+do { \
+    type s_re = (z_re), s_im = (z_im), w_re, w_im, t; \
+\
+    if (ship) { \
+        s_re = abs(s_re); \
+        s_im = abs(s_im); \
+    } \
+\
+    if ((power) == 2) { \
+        t = s_re*s_re - s_im*s_im + (c_re); \
+        z_im = 2*s_re*s_im + (c_im); \
+        z_re = t; \
+    } else { \
+        w_re = s_re; \
+        w_im = s_im; \
+\
+        for (int e = 1; e < (power); ++e) { \
+            t = w_re*s_re - w_im*s_im; \
+            w_im = w_re*s_im + w_im*s_re; \
+            w_re = t; \
+        } \
+\
+        z_re = w_re + (c_re); \
+        z_im = w_im + (c_im); \
+    } \
+} while (0)
 
-    if (retval == EXIT_SUCCESS) {
-        printf("Finished. Image stored in '%s'.\n", opts->filename);
-    } else {
-        eprintf("failed to write bitmap to file.\n");
+/*
+ * compute number of iterations of a pixel in precision `type` for the formula
+ * of `power` and `ship`. coordinates are computed from the region and 
+ * scalings with the given `suffix`. julia sets start at the pixel instead of 
+ * zero and add the constant of the set
+ */
+#define MO_PIXEL(name, type, suffix, abs, power, ship) \
+static int name(int col, int row, mo_scale_t *scale, mo_opts_t *opts) \
+{ \
+    struct { type re, im; } a, b, p; \
+    a.re = a.im = 0; \
+\
+    /* scale display coordinates to actual region */ \
+    b.re = opts->min_re##suffix + ((type) col*scale->re##suffix); \
+    b.im = opts->min_im##suffix + ((type) (opts->height - 1 - row)*scale->im##suffix); \
+\
+    if (opts->julia) { \
+        a = b; \
+        b.re = (type) opts->julia_re; \
+        b.im = (type) opts->julia_im; \
+    } \
+\
+    /* points in the main cardioid or the period-2 bulb never diverge */ \
+    if (opts->cardioid) { \
+        type x = b.re - (type) 0.25; \
+        type y2 = b.im*b.im; \
+        type q = x*x + y2; \
+\
+        if ((q*(q + x) <= (type) 0.25*y2) || \
+                ((b.re + 1)*(b.re + 1) + y2 <= (type) 0.0625)) { \
+            return opts->max_iterations; \
+        } \
+    } \
+\
+    /* calculate z0, z1, until divergence or maximum iterations */ \
+    p = a; \
+    int n = 0, period = 1; \
+    type r2; \
+\
+    do  { \
+        MO_STEP(type, power, ship, abs, a.re, a.im, b.re, b.im); \
+        r2 = a.re*a.re + a.im*a.im; \
+        ++n; \
+\
+        /* brent's cycle detection: compare z with the one saved at the last power \
+         * of two. an exact match means the orbit repeats and will never diverge */ \
+        if (opts->periodicity) { \
+            if (a.re == p.re && a.im == p.im) { \
+                return opts->max_iterations; \
+            } \
+\
+            if (n == period) { \
+                p = a; \
+                period *= 2; \
+            } \
+        } \
+    } while (r2 < MO_THRESHOLD && n < opts->max_iterations); \
+\
+    return n; \
+}
+
+/*
+ * formulas with compiled kernels: prefix of the kernel names, power, ship
+ */
+#define MO_FRACTALS(X) \
+    X(mandelbrot, 2, 0) X(multibrot3, 3, 0) X(multibrot4, 4, 0) \
+    X(multibrot5, 5, 0) X(multibrot6, 6, 0) \
+    X(burning_ship, 2, 1) X(burning_ship3, 3, 1) X(burning_ship4, 4, 1) \
+    X(burning_ship5, 5, 1) X(burning_ship6, 6, 1)
+
+#define MO_PIXELS(prefix, power, ship) \
+    MO_PIXEL(prefix##_float, float, , fabsf, power, ship) \
+    MO_PIXEL(prefix##_double, double, , fabs, power, ship) \
+    MO_PIXEL(prefix##_long, long double, _long, fabsl, power, ship)
+
+MO_FRACTALS(MO_PIXELS)
+
+/*
+ * continue the iteration of a pixel from z after n iterations in double 
+ * precision. c is computed from the pixel lattice, so all views of a zoom 
+ * level agree on it. z is updated for later continuation, or set to NAN if 
+ * the pixel is known to never diverge
+ */
+static int mandelbrot_resume(int col, int row, int n, mo_complex_t *z, mo_scale_t *scale, 
+        mo_opts_t *opts)
+{
+    mo_complex_t a = *z, b, p = *z;
+    int period = 1, steps = 0;
+    double r2 = a.re*a.re + a.im*a.im, tmp;
+
+    b.re = (double) (opts->lattice_col + col)*scale->re;
+    b.im = -(double) (opts->lattice_row + row)*scale->im;
+
+    /* points in the main cardioid or the period-2 bulb never diverge */
+    if (opts->cardioid && n == 0) {
+        double x = b.re - 0.25;
+        double y2 = b.im*b.im;
+        double q = x*x + y2;
+
+        if ((q*(q + x) <= 0.25*y2) || ((b.re + 1)*(b.re + 1) + y2 <= 0.0625)) {
+            z->re = z->im = NAN;
+            return opts->max_iterations;
+        }
     }
-    
-    free(rows);
-    free(data);
-    free(rgb);
 
-    return retval;
+    while (r2 < MO_THRESHOLD && n < opts->max_iterations) {
+        tmp = a.re*a.re - a.im*a.im + b.re;
+        a.im = 2*a.re*a.im + b.im;
+        a.re = tmp;
+        r2 = a.re*a.re + a.im*a.im;
+        ++n;
+        ++steps;
+
+        /* brent's cycle detection, see MO_PIXEL */
+        if (opts->periodicity) {
+            if (a.re == p.re && a.im == p.im) {
+                z->re = z->im = NAN;
+                return opts->max_iterations;
+            }
+
+            if (steps == period) {
+                p = a;
+                period *= 2;
+            }
+        }
+    }
+
+    *z = a;
+
+    return n;
 }
 
 /*
- * slave process logic
+ * compute number of iterations of a pixel in deep zoom mode. instead of c and 
+ * z, the differences dc and dz to the reference orbit Z are iterated:
+ *
+ *     dz' = 2*Z*dz + dz^2 + dc
+ *
+ * the first iterations are skipped by the series approximation. if z gets
+ * closer to zero than dz, Z can no longer represent the orbit of the pixel 
+ * (glitch), so dz is rebased to the start of the reference orbit. the same 
+ * happens if the reference orbit ends
  */
-static int slave_proc(int proc_id, mo_opts_t *opts) 
+static int perturbation(int col, int row, mo_scale_t *scale, mo_opts_t *opts)
 {
-    int *rows = (int *) malloc(opts->blocksize*sizeof(*rows));
-    long *data = (long *) malloc((opts->width + 1)*opts->blocksize*sizeof(*data));
-    mo_scale_t *scale = (mo_scale_t *) malloc(sizeof(*scale));
-    
-    if (rows == NULL || data == NULL || scale == NULL) {
-        free(rows); free(data); free(scale);
+    const mo_orbit_t *orbit = opts->orbit;
+    mo_complex_t dc, dz, z, a2;
+    double r2, tmp;
+
+    /* difference to the view center */
+    dc.re = (double) col*scale->re - opts->axis_length;
+    dc.im = (double) (opts->height - 1 - row)*scale->im - opts->axis_length;
+
+    /* dz = A*dc + B*dc^2 + C*dc^3 */
+    a2.re = dc.re*dc.re - dc.im*dc.im;
+    a2.im = 2*dc.re*dc.im;
+    dz.re = orbit->a.re*dc.re - orbit->a.im*dc.im + orbit->b.re*a2.re - orbit->b.im*a2.im +
+        orbit->c.re*(a2.re*dc.re - a2.im*dc.im) - orbit->c.im*(a2.re*dc.im + a2.im*dc.re);
+    dz.im = orbit->a.re*dc.im + orbit->a.im*dc.re + orbit->b.re*a2.im + orbit->b.im*a2.re +
+        orbit->c.re*(a2.re*dc.im + a2.im*dc.re) + orbit->c.im*(a2.re*dc.re - a2.im*dc.im);
+
+    int n = orbit->skip, m = orbit->skip;
+
+    while (n < opts->max_iterations) {
+        tmp = 2*(orbit->re[m]*dz.re - orbit->im[m]*dz.im) + dz.re*dz.re - dz.im*dz.im + dc.re;
+        dz.im = 2*(orbit->re[m]*dz.im + orbit->im[m]*dz.re) + 2*dz.re*dz.im + dc.im;
+        dz.re = tmp;
+        ++n;
+        ++m;
+
+        z.re = orbit->re[m] + dz.re;
+        z.im = orbit->im[m] + dz.im;
+        r2 = z.re*z.re + z.im*z.im;
+
+        if (r2 >= MO_THRESHOLD) break;
+
+        if (r2 < dz.re*dz.re + dz.im*dz.im || m == orbit->length - 1) {
+            dz = z;
+            m = 0;
+        }
+    }
+
+    return n;
+}
+
+/*
+ * row kernel of the deep zoom mode
+ */
+static void perturbation_row(int row, int col, int count, mo_scale_t *scale, mo_opts_t *opts, 
+        int *iterations)
+{
+    for (int i = 0; i < count; ++i) {
+        iterations[i] = perturbation(col + i, row, scale, opts);
+    }
+}
+
+/*
+ * compute the reference orbit for the deep zoom mode on process 0 and 
+ * broadcast it to all processes
+ */
+static int reference_orbit(int proc_id, mo_opts_t *opts)
+{
+    mo_orbit_t *orbit = (mo_orbit_t *) calloc(1, sizeof(*orbit));
+    double *values = (double *) malloc(2*(opts->max_iterations + 1)*sizeof(*values));
+    double coefficients[6];
+    double start_time = MPI_Wtime();
+    int ok = (orbit != NULL && values != NULL);
+
+    if (ok) {
+        orbit->re = values;
+        orbit->im = values + opts->max_iterations + 1;
+    } else {
+        eprintf("unable to allocate memory for reference orbit.\n");
+    }
+
+    if (ok && proc_id == 0) {
+        ok = (compute_orbit(orbit, opts) == EXIT_SUCCESS);
+        series_approximation(orbit, opts);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+    if (!ok) {
+        free(values);
+        free(orbit);
         return EXIT_FAILURE;
     }
 
-    long pixel_color;
-    int offset;
-    
-    MPI_Status status;
-    
-    /* compute factor for color scaling */
-    scale->color = (double) (opts->max_color - opts->min_color) / 
-        (double) (opts->max_iterations - 1);
+    coefficients[0] = orbit->a.re; coefficients[1] = orbit->a.im;
+    coefficients[2] = orbit->b.re; coefficients[3] = orbit->b.im;
+    coefficients[4] = orbit->c.re; coefficients[5] = orbit->c.im;
 
-    /* compute factors to scale computational region to imagesize */
-    scale->re = (double) (opts->max_re - opts->min_re) / (double) opts->width;
-    scale->im = (double) (opts->max_im - opts->min_im) / (double) opts->height;
-    
-    /* receive row(s) and start computation if status is MO_CALC */
-    while ((MPI_Recv(rows, opts->blocksize, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD,
-            &status) == MPI_SUCCESS) && status.MPI_TAG == MO_CALC) {
-        for (int i = 0; i < opts->blocksize; ++i) {
-            offset = opts->width*i;
-            data[offset] = rows[i];
+    MPI_Bcast(&orbit->length, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&orbit->skip, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(coefficients, 6, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(orbit->re, orbit->length, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(orbit->im, orbit->length, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 
-            /* compute pixel colors using mandelbrot algorithm */
-            for (int col = 0; col < opts->width; ++col) {
-                pixel_color = mandelbrot(col, rows[i], scale, opts);
-                data[offset + col + 1] = pixel_color;
-            }
+    orbit->a.re = coefficients[0]; orbit->a.im = coefficients[1];
+    orbit->b.re = coefficients[2]; orbit->b.im = coefficients[3];
+    orbit->c.re = coefficients[4]; orbit->c.im = coefficients[5];
+
+    opts->orbit = orbit;
+
+    if (proc_id == 0) {
+        printf("Reference orbit computed in %g sec: %d iterations, %d skipped by series " \
+            "approximation.\n\n", MPI_Wtime() - start_time, orbit->length - 1, orbit->skip);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * iterate the view center with arbitrary precision until it diverges or the 
+ * maximum iterations are reached. the precision is chosen from the axis 
+ * length, so pixel spacings are resolved
+ */
+static int compute_orbit(mo_orbit_t *orbit, mo_opts_t *opts)
+{
+    mpf_t c_re, c_im, z_re, z_im, z_re2, z_im2, tmp;
+    int exponent, n;
+    int retval = EXIT_SUCCESS;
+
+    frexp(opts->axis_length, &exponent);
+    mpf_set_default_prec(MO_DEEPBITS + (exponent < 0 ? -exponent : 0));
+
+    mpf_init(c_re); mpf_init(c_im);
+    mpf_init(z_re); mpf_init(z_im);
+    mpf_init(z_re2); mpf_init(z_im2);
+    mpf_init(tmp);
+
+    if (mpf_set_str(c_re, opts->x_str, 10) != 0 || mpf_set_str(c_im, opts->y_str, 10) != 0) {
+        eprintf("invalid decimal offset '%s, %s'.\n", opts->x_str, opts->y_str);
+        retval = EXIT_FAILURE;
+    }
+
+    for (n = 0; retval == EXIT_SUCCESS; ++n) {
+        orbit->re[n] = mpf_get_d(z_re);
+        orbit->im[n] = mpf_get_d(z_im);
+
+        if (n == opts->max_iterations || 
+                orbit->re[n]*orbit->re[n] + orbit->im[n]*orbit->im[n] >= MO_THRESHOLD) {
+            break;
         }
 
-        /* send row(s) to master */
-        MPI_Send(data, (opts->width + 1)*opts->blocksize, MPI_LONG, 0, MO_DATA, MPI_COMM_WORLD);
+        /* z = z^2 + c */
+        mpf_mul(z_re2, z_re, z_re);
+        mpf_mul(z_im2, z_im, z_im);
+        mpf_mul(tmp, z_re, z_im);
+        mpf_mul_2exp(tmp, tmp, 1);
+        mpf_add(z_im, tmp, c_im);
+        mpf_sub(z_re, z_re2, z_im2);
+        mpf_add(z_re, z_re, c_re);
     }
 
-    free(rows);
-    free(data);
-    free(scale);
+    orbit->length = n + 1;
 
-    return EXIT_SUCCESS;
+    mpf_clear(c_re); mpf_clear(c_im);
+    mpf_clear(z_re); mpf_clear(z_im);
+    mpf_clear(z_re2); mpf_clear(z_im2);
+    mpf_clear(tmp);
+
+    return retval;
 }
 
 /*
- * compute pixel color using the mandelbrot algorithm
+ * find the number of iterations which can be skipped for all pixels by 
+ * approximating dz with the series
+ *
+ *     dz = A*dc + B*dc^2 + C*dc^3
+ *     A' = 2*Z*A + 1,  B' = 2*Z*B + A^2,  C' = 2*Z*C + 2*A*B
+ *
+ * the series is stopped once the third order term becomes significant for 
+ * the largest dc of the view, or a pixel might escape or need rebasing
  */
-static long mandelbrot(int col, int row, mo_scale_t *scale, mo_opts_t *opts) 
+static void series_approximation(mo_orbit_t *orbit, mo_opts_t *opts)
 {
-    mo_complex_t a, b;
-    a.re = a.im = 0;
+    const double r = fabs(opts->axis_length)*MO_SQRT2;
+    mo_complex_t a = { 0, 0 }, b = { 0, 0 }, c = { 0, 0 }, z, tmp_a, tmp_b, tmp_c;
+    double abs_z, delta;
 
-    /* scale display coordinates to actual region */
-    b.re = opts->min_re + ((double) col*scale->re);
-    b.im = opts->min_im + ((double) (opts->height - 1 - row)*scale->im);
+    orbit->skip = 0;
+    orbit->a = a;
+    orbit->b = b;
+    orbit->c = c;
 
-    /* calculate z0, z1, until divergence or maximum iterations */
-    int n = 0;
-    double r2, tmp;
+    for (int n = 0; n + 2 < orbit->length; ++n) {
+        z.re = orbit->re[n];
+        z.im = orbit->im[n];
 
-    do  {
-        tmp = a.re*a.re - a.im*a.im + b.re;
-        a.im = 2*a.re*a.im + b.im;
-        a.re = tmp;
-        r2 = a.re*a.re + a.im*a.im;
-        ++n;
-    } while (r2 < MO_THRESHOLD && n < opts->max_iterations);
+        tmp_a = a;
+        tmp_b = b;
+
+        a.re = 2*(z.re*tmp_a.re - z.im*tmp_a.im) + 1;
+        a.im = 2*(z.re*tmp_a.im + z.im*tmp_a.re);
+        b.re = 2*(z.re*tmp_b.re - z.im*tmp_b.im) + tmp_a.re*tmp_a.re - tmp_a.im*tmp_a.im;
+        b.im = 2*(z.re*tmp_b.im + z.im*tmp_b.re) + 2*tmp_a.re*tmp_a.im;
+        tmp_c = c;
+        c.re = 2*(z.re*tmp_c.re - z.im*tmp_c.im) + 2*(tmp_a.re*tmp_b.re - tmp_a.im*tmp_b.im);
+        c.im = 2*(z.re*tmp_c.im + z.im*tmp_c.re) + 2*(tmp_a.re*tmp_b.im + tmp_a.im*tmp_b.re);
+
+        /* bound of dz and distance of Z to zero after this iteration */
+        delta = sqrt(a.re*a.re + a.im*a.im)*r;
+        abs_z = sqrt(orbit->re[n + 1]*orbit->re[n + 1] + orbit->im[n + 1]*orbit->im[n + 1]);
+
+        /* negated, so overflows stop the series as well */
+        if (!(sqrt(c.re*c.re + c.im*c.im)*r*r*r <= MO_SATOLERANCE*delta && 
+                abs_z > 2*delta && abs_z + delta < 2)) {
+            break;
+        }
+
+        orbit->skip = n + 1;
+        orbit->a = a;
+        orbit->b = b;
+        orbit->c = c;
+    }
+}
+
+/*
+ * scalar row kernels, used if no vectorized kernel is supported by the cpu
+ */
+#define MO_SCALAR_ROW_KERNEL(name, pixel) \
+static void name(int row, int col, int count, mo_scale_t *scale, mo_opts_t *opts, \
+        int *iterations) \
+{ \
+    for (int i = 0; i < count; ++i) { \
+        iterations[i] = pixel(col + i, row, scale, opts); \
+    } \
+}
+
+#define MO_SCALAR_ROW_KERNELS(prefix, power, ship) \
+    MO_SCALAR_ROW_KERNEL(prefix##_row_float, prefix##_float) \
+    MO_SCALAR_ROW_KERNEL(prefix##_row_double, prefix##_double) \
+    MO_SCALAR_ROW_KERNEL(prefix##_row_long, prefix##_long)
+
+MO_FRACTALS(MO_SCALAR_ROW_KERNELS)
+
+#ifdef MO_SIMD
+/*
+ * vectorized row kernels
+ *
+ * each kernel iterates `lanes` pixels of precision `type` at once for the 
+ * formula of `power` and `ship`. lanes which already diverged are
+ * masked out of the iteration count, the loop runs until all lanes are done.
+ * the cardioid/bulb and periodicity checks mask out lanes as interior points.
+ * the operations are performed in the same order as in MO_PIXEL and are 
+ * not contracted to fma instructions (-std=c99 implies -ffp-contract=off), so 
+ * the results are bit-identical to the scalar kernel of the same precision.
+ * `itype` is the integer type of the same size as `type`.
+ */
+#define MO_ROW_KERNEL(name, isa, type, itype, lanes, any, power, ship) \
+typedef type name##_vd __attribute__ ((vector_size (sizeof(type)*(lanes)))); \
+typedef itype name##_vl __attribute__ ((vector_size (sizeof(type)*(lanes)))); \
+\
+/* clear the sign bits */ \
+__attribute__ ((target (isa))) \
+static inline name##_vd name##_abs(name##_vd x) \
+{ \
+    const name##_vd zero = { 0 }; \
+\
+    return (name##_vd) ((name##_vl) x & ~(name##_vl) -zero); \
+} \
+\
+__attribute__ ((target (isa))) \
+static void name(int row, int col, int count, mo_scale_t *scale, mo_opts_t *opts, \
+        int *iterations) \
+{ \
+    const name##_vd zero = { 0 }; \
+    const name##_vl none = { 0 }; \
+    const type pixel_im = opts->min_im + ((type) (opts->height - 1 - row)*scale->im); \
+    name##_vd a_re, a_im, b_re, b_im, p_re, p_im, r2, x, y2, q; \
+    name##_vl n, active, interior, cycle; \
+    int period; \
+\
+    for (int i = 0; i < count; i += (lanes)) { \
+        b_re = a_re = a_im = zero; \
+        b_im = zero + pixel_im; \
+        n = interior = none; \
+        active = none - 1; \
+        period = 1; \
+\
+        for (int l = 0; l < (lanes); ++l) { \
+            b_re[l] = opts->min_re + ((type) (col + i + l)*scale->re); \
+        } \
+\
+        if (opts->julia) { \
+            a_re = b_re; \
+            a_im = b_im; \
+            b_re = zero + (type) opts->julia_re; \
+            b_im = zero + (type) opts->julia_im; \
+        } \
+\
+        p_re = a_re; \
+        p_im = a_im; \
+\
+        if (opts->cardioid) { \
+            x = b_re - (type) 0.25; \
+            y2 = b_im*b_im; \
+            q = x*x + y2; \
+            interior = (q*(q + x) <= (type) 0.25*y2) | \
+                ((b_re + 1)*(b_re + 1) + y2 <= (type) 0.0625); \
+            active &= ~interior; \
+        } \
+\
+        for (int k = 1; k <= opts->max_iterations && (any); ++k) { \
+            MO_STEP(name##_vd, power, ship, name##_abs, a_re, a_im, b_re, b_im); \
+            r2 = a_re*a_re + a_im*a_im; \
+            n -= active; \
+            active &= (r2 < MO_THRESHOLD); \
+\
+            if (opts->periodicity) { \
+                cycle = active & (a_re == p_re) & (a_im == p_im); \
+                interior |= cycle; \
+                active &= ~cycle; \
+\
+                if (k == period) { \
+                    p_re = a_re; \
+                    p_im = a_im; \
+                    period *= 2; \
+                } \
+            } \
+        } \
+\
+        for (int l = 0; l < (lanes) && i + l < count; ++l) { \
+            iterations[i + l] = interior[l] ? opts->max_iterations : (int) n[l]; \
+        } \
+    } \
+}
+
+#define MO_ROW_KERNELS(prefix, power, ship) \
+    MO_ROW_KERNEL(prefix##_row_sse2_float, "sse2", float, int, 4, \
+            _mm_movemask_ps((__m128) active), power, ship) \
+    MO_ROW_KERNEL(prefix##_row_avx2_float, "avx2", float, int, 8, \
+            _mm256_movemask_ps((__m256) active), power, ship) \
+    MO_ROW_KERNEL(prefix##_row_avx512_float, "avx512f", float, int, 16, \
+            _mm512_test_epi32_mask((__m512i) active, (__m512i) active), power, ship) \
+    MO_ROW_KERNEL(prefix##_row_sse2, "sse2", double, long long, 2, \
+            _mm_movemask_pd((__m128d) active), power, ship) \
+    MO_ROW_KERNEL(prefix##_row_avx2, "avx2", double, long long, 4, \
+            _mm256_movemask_pd((__m256d) active), power, ship) \
+    MO_ROW_KERNEL(prefix##_row_avx512, "avx512f", double, long long, 8, \
+            _mm512_test_epi64_mask((__m512i) active, (__m512i) active), power, ship)
+
+MO_FRACTALS(MO_ROW_KERNELS)
+
+static int cpu_has_sse2(void) { return __builtin_cpu_supports("sse2"); }
+static int cpu_has_avx2(void) { return __builtin_cpu_supports("avx2"); }
+static int cpu_has_avx512(void) { return __builtin_cpu_supports("avx512f"); }
+#endif /* MO_SIMD */
+
+/*
+ * available row kernels, ordered from fastest to slowest. each precision and
+ * formula ends with a scalar kernel
+ */
+#define MO_KERNEL_ENTRIES(name, supported, prefix, isa, power, ship) \
+    { name, MO_PREC_FLOAT, MO_FORMULA(power, ship), supported, prefix##_row_##isa##_float }, \
+    { name, MO_PREC_DOUBLE, MO_FORMULA(power, ship), supported, prefix##_row_##isa },
+
+#define MO_AVX512_KERNELS(prefix, power, ship) \
+    MO_KERNEL_ENTRIES("avx512", cpu_has_avx512, prefix, avx512, power, ship)
+#define MO_AVX2_KERNELS(prefix, power, ship) \
+    MO_KERNEL_ENTRIES("avx2", cpu_has_avx2, prefix, avx2, power, ship)
+#define MO_SSE2_KERNELS(prefix, power, ship) \
+    MO_KERNEL_ENTRIES("sse2", cpu_has_sse2, prefix, sse2, power, ship)
+#define MO_SCALAR_KERNELS(prefix, power, ship) \
+    { "scalar", MO_PREC_FLOAT, MO_FORMULA(power, ship), NULL, prefix##_row_float }, \
+    { "scalar", MO_PREC_DOUBLE, MO_FORMULA(power, ship), NULL, prefix##_row_double }, \
+    { "scalar", MO_PREC_LONG, MO_FORMULA(power, ship), NULL, prefix##_row_long },
+
+static const mo_kernel_t kernels[] = {
+#ifdef MO_SIMD
+    MO_FRACTALS(MO_AVX512_KERNELS)
+    MO_FRACTALS(MO_AVX2_KERNELS)
+    MO_FRACTALS(MO_SSE2_KERNELS)
+#endif
+    MO_FRACTALS(MO_SCALAR_KERNELS)
+};
+
+/*
+ * pixel functions of each formula and precision
+ */
+#define MO_PIXEL_ENTRIES(prefix, power, ship) \
+    [MO_FORMULA(power, ship)] = { \
+        [MO_PREC_FLOAT] = prefix##_float, \
+        [MO_PREC_DOUBLE] = prefix##_double, \
+        [MO_PREC_LONG] = prefix##_long \
+    },
+
+static int (*const pixels[MO_FORMULAS][MO_PRECS])(int, int, mo_scale_t *, mo_opts_t *) = {
+    MO_FRACTALS(MO_PIXEL_ENTRIES)
+};
+
+/*
+ * compute number of iterations of a pixel using the formula and the 
+ * precision selected for the render
+ */
+static int mandelbrot(int col, int row, mo_scale_t *scale, mo_opts_t *opts) 
+{
+    if (opts->deep) {
+        return perturbation(col, row, scale, opts);
+    }
+
+    return pixels[opts->formula][opts->precision](col, row, scale, opts);
+}
+
+/*
+ * select row kernel of the given precision and formula by name. if the cpu 
+ * does not support the requested kernel or there is none of the precision 
+ * (or name is "auto"), the fastest supported kernel is selected instead. 
+ * returns NULL if there is no kernel named `name`
+ */
+static const mo_kernel_t *select_kernel(const char *name, int precision, int formula)
+{
+    const int count = sizeof(kernels)/sizeof(*kernels);
+    int i = 0;
+
+    if (strcmp(name, "auto") != 0) {
+        for (i = 0; i < count && strcmp(kernels[i].name, name) != 0; ++i);
+
+        if (i == count) return NULL;
+    }
+
+    /* fall back to the next supported kernel */
+    for (; i < count; ++i) {
+        if (kernels[i].precision == precision && kernels[i].formula == formula && 
+                (kernels[i].supported == NULL || kernels[i].supported())) break;
+    }
+
+    return &kernels[i];
+}
+
+/*
+ * kernel of the deep zoom mode, which is not selectable via '-k'
+ */
+static const mo_kernel_t deep_kernel = { "perturbation", MO_PREC_DOUBLE, 0, NULL, 
+    perturbation_row };
+
+/*
+ * kernel used for rendering: the deep zoom kernel if requested, otherwise 
+ * the row kernel selected via '-k'
+ */
+static const mo_kernel_t *pixel_kernel(mo_opts_t *opts)
+{
+    return opts->deep ? &deep_kernel : select_kernel(opts->kernel, opts->precision, 
+            opts->formula);
+}
+
+/*
+ * compute factors for color scaling and to scale the computational region to 
+ * the image size. in deep zoom mode the bounds of the region can't be told 
+ * apart in double precision, so the axis length is used instead. the tile 
+ * cache needs the exact spacing of the pixel lattice as well
+ */
+static void init_scale(mo_scale_t *scale, mo_opts_t *opts)
+{
+    scale->color = (double) (opts->max_color - opts->min_color) / 
+        (double) (opts->max_iterations - 1);
+
+    if (opts->deep || opts->cache_dir != NULL) {
+        scale->re = 2*opts->axis_length / (double) opts->width;
+        scale->im = 2*opts->axis_length / (double) opts->height;
+    } else {
+        scale->re = (double) (opts->max_re - opts->min_re) / (double) opts->width;
+        scale->im = (double) (opts->max_im - opts->min_im) / (double) opts->height;
+    }
 
-    /* scale color and return */
+    scale->re_long = 2*(long double) opts->axis_length / (long double) opts->width;
+    scale->im_long = 2*(long double) opts->axis_length / (long double) opts->height;
+}
+
+/*
+ * scale iteration count to pixel color
+ */
+static inline long pixel_color(int n, mo_scale_t *scale, mo_opts_t *opts)
+{
     return (long) ((n - 1)*scale->color) + opts->min_color;
 }
 
 /*
  * print progress bar 
  */
-static inline void print_progress(int rows_processed, int row_count)
+static inline void print_progress(int64_t pixels_processed, int64_t pixel_count)
 {
-    int r = row_count/MO_PUPDATE;
+    static int last_update = -1;
+    int update = (int) (pixels_processed*MO_PUPDATE/pixel_count);
     
     /* only update MO_PUPDATE times */
-    if (r == 0 || rows_processed % r != 0) return;
+    if (update == last_update) return;
+
+    last_update = update;
 
     /* calulate ratio and current position */
-    float ratio = rows_processed/(float) row_count;
+    float ratio = pixels_processed/(float) pixel_count;
     int pos = ratio*MO_PWIDTH;
  
     /* print percentage and progress bar */
@@ -477,25 +5592,27 @@ static inline void print_progress(int rows_processed, int row_count)
 }
 
 /*
- * write bitmap file
- * derived from http://cpansearch.perl.org/src/DHUNT/PDL-Planet-0.05/libimage/bmp.c
+ * length of bitmap lines in bytes, which must be a multiple of 4 bytes
  */
-static int write_bitmap(const char *filename, int width, int height, char *rgb)
+static inline int bitmap_line_size(int width)
 {
-    int i, j, pixel_pos;
-    int bytes_per_line;
-    unsigned char *line;
+    return (3*(width + 1)/4)*4;
+}
 
-    FILE *file;
+/*
+ * serialize the bitmap header into header (54 bytes). returns the file size
+ * derived from http://cpansearch.perl.org/src/DHUNT/PDL-Planet-0.05/libimage/bmp.c
+ */
+static int64_t bitmap_header(unsigned char *header, int width, int height)
+{
+    int64_t size_image;
     mo_bmp_header_t bmph;
 
-    /* the length of each line must be a multiple of 4 bytes */
-    bytes_per_line = (3*(width + 1)/4)*4;
+    size_image = (int64_t) bitmap_line_size(width)*height;
 
     bmph.type[0] = 'B';
     bmph.type[1] = 'M';
     bmph.offbits = 54;
-    bmph.fsize = bmph.offbits + bytes_per_line*height;
     bmph.reserved = 0;
     bmph.hsize = 40;
     bmph.width = width;
@@ -503,57 +5620,197 @@ static int write_bitmap(const char *filename, int width, int height, char *rgb)
     bmph.planes = 1;
     bmph.bit_count = 24;
     bmph.compression = 0;
-    bmph.size_image = bytes_per_line*height;
     bmph.x_pels_per_meter = 0;
     bmph.y_pels_per_meter = 0;
     bmph.clr_used = 0;       
     bmph.clr_important = 0; 
 
-    file = fopen(filename, "wb");
+    /* sizes which exceed the 32 bit header fields are set to 0, which is 
+     * allowed for uncompressed bitmaps */
+    if (size_image + bmph.offbits <= UINT32_MAX) {
+        bmph.fsize = (int) (uint32_t) (size_image + bmph.offbits);
+        bmph.size_image = (int) (uint32_t) size_image;
+    } else {
+        bmph.fsize = 0;
+        bmph.size_image = 0;
+    }
+
+    memcpy(header, &bmph.type, 2);
+    memcpy(header + 2, &bmph.fsize, 4);
+    memcpy(header + 6, &bmph.reserved, 4);
+    memcpy(header + 10, &bmph.offbits, 4);
+    memcpy(header + 14, &bmph.hsize, 4);
+    memcpy(header + 18, &bmph.width, 4);
+    memcpy(header + 22, &bmph.height, 4);
+    memcpy(header + 26, &bmph.planes, 2);
+    memcpy(header + 28, &bmph.bit_count, 2);
+    memcpy(header + 30, &bmph.compression, 4);
+    memcpy(header + 34, &bmph.size_image, 4);
+    memcpy(header + 38, &bmph.x_pels_per_meter, 4);
+    memcpy(header + 42, &bmph.y_pels_per_meter, 4);
+    memcpy(header + 46, &bmph.clr_used, 4);
+    memcpy(header + 50, &bmph.clr_important, 4);
 
-    if (file == NULL) { 
+    return bmph.offbits + size_image;
+}
+
+/*
+ * create bitmap file and write its header, the pixel data is written with
+ * write_bitmap_block() as it becomes available. a resumed render keeps the 
+ * pixel data already in the file. returns the file descriptor or -1 on failure
+ */
+static int open_bitmap(const char *filename, int width, int height, int resume)
+{
+    unsigned char header[54];
+    int64_t file_size = bitmap_header(header, width, height);
+    int fd = open(filename, O_WRONLY | O_CREAT | (resume ? 0 : O_TRUNC), 0644);
+
+    if (fd == -1) { 
         eprintf("unable to open file '%s'.\n", filename);
-        return EXIT_FAILURE;
+        return -1;
     }
-   
-    /* write header */
-    fwrite(&bmph.type, 2, 1, file);
-    fwrite(&bmph.fsize, 4, 1, file);
-    fwrite(&bmph.reserved, 4, 1, file);
-    fwrite(&bmph.offbits, 4, 1, file);
-    fwrite(&bmph.hsize, 4, 1, file);
-    fwrite(&bmph.width, 4, 1, file);
-    fwrite(&bmph.height, 4, 1, file);
-    fwrite(&bmph.planes, 2, 1, file);
-    fwrite(&bmph.bit_count, 2, 1, file);
-    fwrite(&bmph.compression, 4, 1, file);
-    fwrite(&bmph.size_image, 4, 1, file);
-    fwrite(&bmph.x_pels_per_meter, 4, 1, file);
-    fwrite(&bmph.y_pels_per_meter, 4, 1, file);
-    fwrite(&bmph.clr_used, 4, 1, file);
-    fwrite(&bmph.clr_important, 4, 1, file);
-  
-    line = (unsigned char *) malloc(bytes_per_line*sizeof(*line));
-
-    if (line == NULL) {
-        eprintf("unable to allocate memory for line buffer.\n");
-        fclose(file);
+
+    /* write header and allocate the whole file upfront */
+    if (pwrite_all(fd, header, sizeof(header), 0) != EXIT_SUCCESS ||
+            ftruncate(fd, (off_t) file_size) != 0) {
+        eprintf("unable to write file '%s'.\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * open bitmap file with MPI-IO on all processes, the master writes the header.
+ * retval is the status of the calling process, the function fails on all 
+ * processes if it failed on any of them
+ */
+static int open_bitmap_mpi(MPI_File *fh, int retval, int is_master, mo_opts_t *opts)
+{
+    unsigned char header[54];
+    int64_t file_size = bitmap_header(header, opts->width, opts->height);
+    int ok = (retval == EXIT_SUCCESS);
+
+    if (MPI_File_open(MPI_COMM_WORLD, opts->filename, MPI_MODE_WRONLY | MPI_MODE_CREATE, 
+            MPI_INFO_NULL, fh) != MPI_SUCCESS) {
+        if (is_master) eprintf("unable to open file '%s'.\n", opts->filename);
+        *fh = MPI_FILE_NULL;
+        ok = 0;
+    }
+
+    /* truncate to the bitmap size, set_size is collective */
+    if (*fh != MPI_FILE_NULL && MPI_File_set_size(*fh, (MPI_Offset) file_size) != MPI_SUCCESS) {
+        ok = 0;
+    }
+
+    if (ok && is_master && MPI_File_write_at(*fh, 0, header, sizeof(header), MPI_BYTE, 
+            MPI_STATUS_IGNORE) != MPI_SUCCESS) {
+        eprintf("unable to write file '%s'.\n", opts->filename);
+        ok = 0;
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+    if (!ok) {
+        if (*fh != MPI_FILE_NULL) MPI_File_close(fh);
         return EXIT_FAILURE;
     }
 
-    /* write rgb data */
-    for (i = height - 1; i >= 0; i--) {
-        for (j = 0; j < width; j++) {
-            pixel_pos = 3*(width*i + j);
-            line[3*j] = rgb[pixel_pos + 2];
-            line[3*j + 1] = rgb[pixel_pos + 1];
-            line[3*j + 2] = rgb[pixel_pos];
+    return EXIT_SUCCESS;
+}
+
+/*
+ * write bitmap lines of a block to their position in the bitmap file. lines 
+ * are expected in file order (i.e. bottom-up). blocks spanning the whole image
+ * width are written at once, others line by line. lines of rows mirrored at 
+ * the real axis are written to their mirror rows as well
+ */
+static int write_bitmap_block(int fd, char *lines, mo_block_t *block, mo_opts_t *opts)
+{
+    const int64_t bytes_per_line = bitmap_line_size(opts->width);
+    const int64_t offset = bitmap_lines_offset(block->row, block->rows, opts->width, 
+            opts->height);
+    const int64_t line_size = (block->cols == opts->width) ? bytes_per_line : 3*block->cols;
+    int retval = EXIT_SUCCESS;
+
+    if (block->cols == opts->width) {
+        retval = pwrite_all(fd, lines, bytes_per_line*block->rows, offset);
+    } else {
+        for (int i = 0; i < block->rows && retval == EXIT_SUCCESS; ++i) {
+            retval = pwrite_all(fd, lines + line_size*i, line_size, 
+                    offset + bytes_per_line*i + 3*block->col);
+        }
+    }
+
+    for (int i = 0; i < block->rows && opts->mirror > 0 && retval == EXIT_SUCCESS; ++i) {
+        const int row = opts->mirror - (block->row + block->rows - 1 - i);
+
+        if (is_mirrored(row, opts)) {
+            retval = pwrite_all(fd, lines + line_size*i, line_size, 
+                    bitmap_lines_offset(row, 1, opts->width, opts->height) + 3*block->col);
         }
-        fwrite(line, bytes_per_line, 1, file);
     }
 
-    free(line);
-    fclose(file);
+    if (retval != EXIT_SUCCESS) {
+        eprintf("unable to write rows %d-%d to file.\n", block->row, 
+                block->row + block->rows - 1);
+    }
+
+    return retval;
+}
+
+/*
+ * start writing bitmap lines of a block to the file using MPI-IO, like
+ * write_bitmap_block(). requests must hold one request per line of the block
+ */
+static void write_bitmap_block_mpi(MPI_File fh, char *lines, mo_block_t *block, 
+        MPI_Request *requests, mo_opts_t *opts)
+{
+    const int64_t bytes_per_line = bitmap_line_size(opts->width);
+    const int64_t offset = bitmap_lines_offset(block->row, block->rows, opts->width, 
+            opts->height);
+    const int64_t size = bytes_per_line*block->rows;
+
+    /* lines which don't fit in an MPI count are written one at a time */
+    if (block->cols == opts->width && size <= INT_MAX) {
+        MPI_File_iwrite_at(fh, (MPI_Offset) offset, lines, (int) size, MPI_BYTE, requests);
+        return;
+    }
+
+    for (int i = 0; i < block->rows; ++i) {
+        MPI_File_iwrite_at(fh, (MPI_Offset) (offset + bytes_per_line*i + 3*block->col), 
+                lines + (size_t) block_line_size(block->cols, opts)*i, 3*block->cols, 
+                MPI_BYTE, requests + i);
+    }
+}
+
+/*
+ * file offset of the bitmap lines of `rows` rows starting at `row`
+ */
+static inline int64_t bitmap_lines_offset(int row, int rows, int width, int height)
+{
+    return 54 + (int64_t) bitmap_line_size(width)*(height - row - rows);
+}
+
+/*
+ * pwrite() which retries until all bytes are written
+ */
+static int pwrite_all(int fd, const void *buf, int64_t size, int64_t offset)
+{
+    ssize_t written;
+
+    while (size > 0) {
+        written = pwrite(fd, buf, (size_t) size, (off_t) offset);
+
+        if (written == -1) {
+            return EXIT_FAILURE;
+        }
+
+        buf = (const char *) buf + written;
+        size -= written;
+        offset += written;
+    }
 
     return EXIT_SUCCESS;
 }
@@ -18,28 +18,173 @@
 #ifndef _MO_MANDELBROT_H
 #define _MO_MANDELBROT_H
 
+/* pwrite() and 64 bit file offsets */
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <signal.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
 #include <mpi.h>
+#include <gmp.h>
+
+/*
+ * vectorized kernels are available on x86 with GCC-compatible compilers
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MO_SIMD        1
+#include <immintrin.h>
+#endif
 
 /* 
  * default values
  */
 #define MO_N           2                    /* size of problem space (x, y from -MO_N to MO_N) */
 #define MO_THRESHOLD   4                    /* divergence threshold (usually 4) */
+#define MO_POWER       2                    /* default exponent d of z^d + c */
+#define MO_MAXPOWER    6                    /* maximum exponent with a kernel */
 #define MO_SIZE        1024                 /* height & width of the canvas in pixels */
 #define MO_FILENAME    "./mandelbrot.bmp"   /* default filename of resulting bitmap */
+#define MO_FRAMENAME   "./mandelbrot-%05d.bmp" /* default filenames of sequence frames */
+#define MO_PATHLEN     4096                 /* maximum length of filenames of frames */
 #define MO_MAXITER     2000                 /* default maximum iterations */
-#define MO_BLOCKSIZE   1                    /* default # of blocks (rows) to be assigned for 
-                                               computation to a slave each time */
+#define MO_BLOCKSIZE   1                    /* default minimum # of rows of a block assigned 
+                                               for computation to a slave each time */
+#define MO_BLOCKWIDTH  0                    /* default # of columns of a block (0 = width) */
+#define MO_SCHEDULE    MO_SCHED_GUIDED      /* default block size schedule */
+#define MO_MAXBLOCK    (1 << 22)            /* maximum # of pixels of a block */
 #define MO_COLORMIN    0x000000             /* default min color (0x000000 = black) */
 #define MO_COLORMAX    0xffffff             /* default max color (0xffffff = white) */
 #define MO_COLORMASK   0xffffff             /* default color mask (all tones) */
 #define MO_PROGRESS    0                    /* show (1) or hide (0) progress  */
 #define MO_PWIDTH      50                   /* progress bar width */
 #define MO_PUPDATE     20                   /* update progress bar MO_UPDATE times */
+#define MO_KERNEL      "auto"               /* default kernel (best supported by cpu) */
+#define MO_THREADS     1                    /* default # of threads per slave */
+#define MO_DEPTH       2                    /* default # of blocks queued per slave */
+#define MO_COMPRESS    0                    /* run-length encode results (1) or not (0) */
+#define MO_CARDIOID    1                    /* skip points in cardioid/period-2 bulb (1) */
+#define MO_PERIODICITY 1                    /* stop iterating periodic orbits (1) */
+#define MO_SYMMETRY    1                    /* compute rows mirrored at the real axis
+                                               once (1) or not (0) */
+#define MO_MIRRORTOL   1e-6                 /* maximum distance of the mirror image of a
+                                               row from the pixel lattice in rows */
+#define MO_MPIIO       0                    /* slaves write output with MPI-IO (1) or not (0) */
+#define MO_RMA         0                    /* all processes claim blocks via RMA (1) or not (0) */
+#define MO_HIERARCHICAL 0                   /* node leaders split chunks of the master among
+                                               the processes of their node (1) or not (0) */
+#define MO_DEEP        0                    /* deep zoom via perturbation (1) or not (0) */
+#define MO_DEEPBITS    64                   /* precision of the reference orbit in bits 
+                                               beyond the axis length */
+#define MO_SATOLERANCE 1e-12                /* maximum relative size of the third order 
+                                               term of the series approximation */
+#define MO_SQRT2       1.4142135623730951   /* sqrt(2) */
+#define MO_PRECMARGIN  14                   /* bits of the mantissa below the pixel spacing
+                                               required by the automatic precision */
+#define MO_CKPTINTERVAL 60                  /* default # of seconds between checkpoints */
+#define MO_PREVIEWSTEP 16                   /* distance of the pixels of the preview */
+#define MO_PREVIEWITER 256                  /* iteration maximum of the preview */
+#define MO_PIXELCOST   8                    /* cost of a pixel apart from its iterations */
+#define MO_PASSSTEP    8                    /* distance of the pixels of the first pass 
+                                               of the progressive mode */
+#define MO_ANTIALIAS   1                    /* default # of samples per row/column of edge
+                                               pixels (1 = no anti-aliasing) */
+#define MO_MAXANTIALIAS 16                  /* maximum # of samples per row/column */
+#define MO_AARUN       16                   /* maximum # of neighboring edge pixels sampled
+                                               at once */
+#define MO_AAEDGE      0.125                /* relative difference of the iteration counts
+                                               of neighbors which marks edge pixels */
+#define MO_TRACESIZE   1024                 /* initial # of events of a trace */
+#define MO_CACHETILE   128                  /* height & width of the tiles of the tile cache */
+#define MO_CACHEVERSION 3                   /* version of the format of tile cache entries */
+#define MO_TILESIZE    256                  /* height & width of the tiles of the tile pyramid */
+#define MO_MAXBATCH    64                   /* maximum # of requests rendered in one schedule
+                                               by the render server */
+#define MO_MAXCLIENTS  16                   /* maximum # of connections to the render server */
+#define MO_REQUESTLEN  (MO_PATHLEN + 256)   /* maximum length of request lines */
+#define MO_CHUNKSIZE   64                   /* # of pixels per chunk handed out to a thread */
+#define MO_MSMINSIZE   8                    /* rectangles up to this size are computed
+                                               completely by mariani-silver */
+#define MO_MSTASKSIZE  4096                 /* rectangles larger than this are processed
+                                               as separate tasks by mariani-silver */
+
+/*
+ * render modes
+ */
+#define MO_MODE_ROWS   0                    /* compute every pixel of a block */
+#define MO_MODE_MARIANI 1                   /* mariani-silver subdivision of a block */
+#define MO_MODE_PROGRESSIVE 2               /* coarse to fine passes with guessing */
+#define MO_MODES       3                    /* # of render modes */
+
+/*
+ * floating point precisions
+ */
+#define MO_PREC_AUTO   -1                   /* select precision from pixel spacing */
+#define MO_PREC_FLOAT  0                    /* float */
+#define MO_PREC_DOUBLE 1                    /* double */
+#define MO_PREC_LONG   2                    /* long double */
+#define MO_PRECS       3                    /* # of precisions */
+
+/*
+ * iteration formulas of the kernels: z^power + c, the burning ship (ship = 1) 
+ * takes the absolute values of the real and imaginary part of z first
+ */
+#define MO_FORMULA(power, ship) (2*((power) - 2) + (ship))
+#define MO_FORMULAS    MO_FORMULA(MO_MAXPOWER + 1, 0) /* # of formulas */
+
+/*
+ * block size schedules
+ */
+#define MO_SCHED_GUIDED 0                   /* large blocks first, shrinking towards the end */
+#define MO_SCHED_FIXED 1                    /* blocks of `blocksize` rows */
+#define MO_SCHED_STATIC 2                   /* one chunk of rows of equal cost per slave */
+#define MO_SCHEDS      3                    /* # of schedules */
+
+/*
+ * features which cannot be combined with each other, see `rules`
+ */
+#define MO_FEAT_FORMULA      (1 << 0)       /* '--power', '--burning-ship' or '--julia' */
+#define MO_FEAT_DEEP         (1 << 1)       /* '--deep' */
+#define MO_FEAT_CACHE        (1 << 2)       /* '--cache' */
+#define MO_FEAT_KEYFRAMES    (1 << 3)       /* '--keyframes' */
+#define MO_FEAT_MPIIO        (1 << 4)       /* '--mpi-io' */
+#define MO_FEAT_RMA          (1 << 5)       /* '--rma' */
+#define MO_FEAT_SERVE        (1 << 6)       /* '--serve' */
+#define MO_FEAT_CHECKPOINT   (1 << 7)       /* '--checkpoint' */
+#define MO_FEAT_RESUME       (1 << 8)       /* '--resume' */
+#define MO_FEAT_TILES        (1 << 9)       /* '--tiles' */
+#define MO_FEAT_PROGRESSIVE  (1 << 10)      /* '--mode progressive' */
+#define MO_FEAT_FIXED        (1 << 11)      /* '--schedule fixed' */
+#define MO_FEAT_STATIC       (1 << 12)      /* '--schedule static' */
+#define MO_FEAT_HIERARCHICAL (1 << 13)      /* '--hierarchical' */
+#define MO_FEAT_COMPRESS     (1 << 14)      /* '-z' */
+#define MO_FEAT_ANTIALIAS    (1 << 15)      /* '--antialias' */
+#define MO_FEAT_SYMMETRY     (1 << 16)      /* symmetry, unless '--no-symmetry' */
+
+/*
+ * trace events
+ */
+#define MO_EV_COMPUTE  0                    /* computation of a block */
+#define MO_EV_RECV     1                    /* waiting for a message */
+#define MO_EV_SEND     2                    /* waiting for a send to complete */
+#define MO_EV_COLOR    3                    /* color mapping of a block */
+#define MO_EV_DECODE   4                    /* decoding a result message (master) */
+#define MO_EV_WRITE    5                    /* writing a block to the bitmap */
+#define MO_EVENTS      6                    /* # of event types */
 
 /*
  * communication flags
@@ -47,6 +192,43 @@
 #define MO_CALC        1                    /* "calc" message flag (master to slave) */
 #define MO_DATA        2                    /* "data" message flag (slave to master) */
 #define MO_STOP        3                    /* "stop" message flag (master to slave) */
+#define MO_PASS        4                    /* "end of pass" message flag (master to slave) */
+
+/*
+ * encodings of result messages
+ */
+#define MO_RAW         0                    /* one value per pixel */
+#define MO_RLE         1                    /* (run, value) pairs */
+#define MO_WRITTEN     2                    /* no values, slave wrote the rows itself */
+#define MO_FAILED      3                    /* no values, slave failed to write the rows */
+
+/*
+ * values of long options without short equivalent
+ */
+#define MO_OPT_NO_CARDIOID     256
+#define MO_OPT_NO_PERIODICITY  257
+#define MO_OPT_MODE            258
+#define MO_OPT_MPIIO           259
+#define MO_OPT_SCHEDULE        260
+#define MO_OPT_RMA             261
+#define MO_OPT_DEEP            262
+#define MO_OPT_PRECISION       263
+#define MO_OPT_KEYFRAMES       264
+#define MO_OPT_FRAMES          265
+#define MO_OPT_CACHE           266
+#define MO_OPT_CHECKPOINT      267
+#define MO_OPT_CKPTINTERVAL    268
+#define MO_OPT_RESUME          269
+#define MO_OPT_STATS           270
+#define MO_OPT_TRACE           271
+#define MO_OPT_ANTIALIAS       272
+#define MO_OPT_TILES           273
+#define MO_OPT_SERVE           274
+#define MO_OPT_NO_SYMMETRY     275
+#define MO_OPT_HIERARCHICAL    276
+#define MO_OPT_POWER           277
+#define MO_OPT_BURNING_SHIP    278
+#define MO_OPT_JULIA           279
 
 /*
  * function marcos
@@ -70,6 +252,57 @@ typedef struct _mo_complex
     double im;                  /* imaginary part */
 } mo_complex_t;
 
+/*
+ * structdef for the reference orbit of the deep zoom mode
+ */
+typedef struct _mo_orbit
+{
+    double *re, *im;            /* reference orbit Z at the view center */
+    int length;                 /* # of points of the reference orbit */
+    int skip;                   /* # of iterations skipped by series approximation */
+    mo_complex_t a, b, c;       /* series coefficients after `skip` iterations */
+} mo_orbit_t;
+
+/*
+ * structdef for keyframes of a sequence
+ */
+typedef struct _mo_keyframe
+{
+    long double x, y;           /* center */
+    double axis_length;         /* absolute value range of x/y-axis */
+    int max_iterations;         /* iteration maximum */
+} mo_keyframe_t;
+
+/*
+ * structdef for requests of the render server
+ */
+typedef struct _mo_request
+{
+    mo_keyframe_t view;         /* center, axis length and iteration maximum */
+    int width, height;          /* image width/height */
+    long min_color, max_color;  /* color ranges */
+    char filename[MO_PATHLEN];  /* filename of resulting bitmap */
+    int client;                 /* client awaiting the reply or -1 if replied (process 0) */
+    double time;                /* time the request arrived (process 0) */
+} mo_request_t;
+
+/*
+ * structdef for run time statistics of a process. all members are doubles, 
+ * so they are gathered as an array of MO_STATS doubles
+ */
+typedef struct _mo_stats
+{
+    double seconds;             /* wall clock time of the computation */
+    double compute;             /* seconds spent computing iteration counts */
+    double communication;       /* seconds spent waiting for messages */
+    double color;               /* seconds spent scaling iteration counts to colors */
+    double write;               /* seconds spent writing the bitmap */
+    double iterations;          /* sum of the iteration counts of all computed pixels */
+    double pixels;              /* # of computed pixels */
+} mo_stats_t;
+
+#define MO_STATS       (sizeof(mo_stats_t)/sizeof(double))
+
 /* 
  * stuctdef for core options 
  */
@@ -80,10 +313,69 @@ typedef struct _mo_opts
     double max_re, min_re;      /* real value range */
     double max_im, min_im;      /* imaginary value range */
     int max_iterations;         /* iteration maximum */
-    int blocksize;              /* # of rows to be send to slave at once */
+    int blocksize;              /* minimum # of rows to be send to slave at once */
+    int block_width;            /* # of columns to be send to slave at once */
+    int schedule;               /* block size schedule (MO_SCHED_*) */
+    int max_rows;               /* # of rows of the largest block */
     long min_color, max_color;  /* color ranges */
     long color_mask;            /* color mask */
     int show_progress;          /* if 1, show progress */
+    const char *kernel;         /* name of requested row kernel */
+    int threads;                /* # of threads per slave */
+    int depth;                  /* # of blocks queued per slave */
+    int compress;               /* if 1, run-length encode results */
+    int iteration_size;         /* size of iteration counts in result messages */
+    int cardioid;               /* if 1, skip points in cardioid/period-2 bulb */
+    int periodicity;            /* if 1, stop iterating periodic orbits */
+    int power;                  /* exponent d of z^d + c */
+    int burning_ship;           /* if 1, iterate the absolute values of re/im of z */
+    int julia;                  /* if 1, render the julia set of the constant c */
+    long double julia_re, julia_im; /* constant c of the julia set */
+    int formula;                /* iteration formula of the kernels (MO_FORMULA) */
+    int symmetry;               /* if 1, rows mirrored at the real axis are computed once */
+    int mirror;                 /* sum of the indices of two rows mirrored at the real
+                                   axis (0 = no rows are mirrored) */
+    int *mirrored;              /* # of rows copied from their mirror rows above each 
+                                   row (height + 1 entries) or NULL */
+    int mode;                   /* render mode (MO_MODE_*) */
+    int antialias;              /* # of samples per row/column of edge pixels */
+    int mpi_io;                 /* if 1, slaves write output with MPI-IO */
+    int rma;                    /* if 1, all processes claim blocks via RMA */
+    int hierarchical;           /* if 1, node leaders split chunks among their node */
+    int node_count;             /* # of node leaders (0 = the master schedules all slaves) */
+    MPI_Comm comm;              /* communicator of the master (rank 0) and its slaves */
+    MPI_Comm node_comm;         /* communicator of the node leader (rank 0) and its 
+                                   workers or MPI_COMM_NULL */
+    MPI_Win node_win;           /* shared window of the node leader's chunks */
+    char *node_buffers;         /* chunks in the shared window or NULL */
+    int deep;                   /* if 1, deep zoom via perturbation */
+    const char *x_str, *y_str;  /* x/y-offsets as given, for the reference orbit */
+    double axis_length;         /* absolute value range of x/y-axis */
+    long double min_re_long;    /* minimum real value in long double precision */
+    long double min_im_long;    /* minimum imaginary value in long double precision */
+    int precision;              /* floating point precision (MO_PREC_*) */
+    int select_precision;       /* if 1, precision is selected for each frame */
+    mo_keyframe_t *keyframes;   /* keyframes of a sequence or NULL */
+    int keyframe_count;         /* # of keyframes */
+    int frame_count;            /* # of frames of the sequence (1 if no sequence) */
+    mo_orbit_t *orbit;          /* reference orbit of the deep zoom mode */
+    const char *cache_dir;      /* directory of the tile cache or NULL */
+    const char *tiles;          /* name of the tile pyramid or NULL */
+    const char *serve;          /* socket of the render server ("-" = stdin) or NULL */
+    mo_request_t *requests;     /* requests rendered as frames or NULL */
+    struct _mo_server *server;  /* state of the render server (process 0) or NULL */
+    int tile_levels;            /* # of levels of the tile pyramid */
+    int64_t lattice_col;        /* pixel lattice index of the first column */
+    int64_t lattice_row;        /* pixel lattice index of the first row */
+    const char *checkpoint;     /* filename of the checkpoint or NULL */
+    double checkpoint_interval; /* # of seconds between checkpoints */
+    int resume;                 /* if 1, only blocks missing in the checkpoint are computed */
+    int workers;                /* # of processes the block schedule is planned for */
+    int *partition;             /* first rows of the chunks of the static schedule */
+    const char *stats_file;     /* csv file statistics are appended to or NULL */
+    mo_stats_t stats;           /* run time statistics of this process */
+    struct _mo_trace *trace;    /* trace of this process or NULL */
+    int instrument;             /* if 1, events are timed for '--stats' or '--trace' */
 } mo_opts_t;
 
 /*
@@ -93,8 +385,238 @@ typedef struct _mo_scale
 {
     double color, im, re;       /* scalings of color, imaginary and 
                                    real part for computation */
+    long double im_long, re_long; /* scalings of imaginary and real part in 
+                                   long double precision */
 } mo_scale_t;
 
+/*
+ * row kernel: computes the iteration counts of `count` pixels of a row 
+ * starting at column `col` and stores them in `iterations`
+ */
+typedef void (*mo_kernel_fn)(int, int, int, mo_scale_t *, mo_opts_t *, int *);
+
+/*
+ * structdef for row kernels
+ */
+typedef struct _mo_kernel
+{
+    const char *name;           /* name used to select the kernel via '-k' */
+    int precision;              /* floating point precision (MO_PREC_*) */
+    int formula;                /* iteration formula (MO_FORMULA) */
+    int (*supported)(void);     /* returns 1 if the cpu supports the kernel */
+    mo_kernel_fn fn;            /* kernel function */
+} mo_kernel_t;
+
+/*
+ * structdef for blocks of the image, also used as work message (master to slave)
+ */
+typedef struct _mo_block
+{
+    int64_t index;              /* position of the block in the schedule */
+    int frame;                  /* frame of the sequence the block belongs to */
+    int col, row;               /* first column/row of the block */
+    int cols, rows;             /* # of columns/rows of the block */
+    int level;                  /* # of times the tile of the pyramid is downsampled 
+                                   (0 = computed) */
+} mo_block_t;
+
+/*
+ * structdef for the state of the block schedule
+ */
+typedef struct _mo_sched
+{
+    int64_t index;              /* position of the next block in the schedule */
+    int frame;                  /* frame of the next block */
+    int col, row;               /* first column/row of the next block */
+    int rows;                   /* # of rows of the current band of blocks */
+} mo_sched_t;
+
+/*
+ * structdef for trace events
+ */
+typedef struct _mo_event
+{
+    double start, end;          /* seconds since the start of the trace */
+    double iterations;          /* sum of the iteration counts (compute events) */
+    mo_block_t block;           /* block of the event (index -1 if none) */
+    int type;                   /* type of the event (MO_EV_*) */
+} mo_event_t;
+
+/*
+ * structdef for the trace of a process
+ */
+typedef struct _mo_trace
+{
+    const char *filename;       /* file the trace of all processes is written to */
+    double origin;              /* time the trace started */
+    mo_event_t *events;         /* recorded events */
+    int count, size;            /* # of recorded/allocated events */
+    int dropped;                /* # of events dropped for lack of memory */
+} mo_trace_t;
+
+/*
+ * structdef for the header of result messages (slave to master),
+ * followed by `length` values of `iteration_size` bytes and `samples`
+ * anti-aliased pixels (see block_samples())
+ */
+typedef struct _mo_block_header
+{
+    mo_block_t block;           /* block the values belong to */
+    int encoding;               /* MO_RAW or MO_RLE */
+    int length;                 /* # of values following the header */
+    int samples;                /* # of anti-aliased pixels following the values */
+} mo_block_header_t;
+
+/*
+ * structdef for anti-aliased pixels of a block
+ */
+typedef struct _mo_sample
+{
+    int index;                  /* position of the pixel in the block */
+    int color;                  /* mean color of the pixel's samples */
+} mo_sample_t;
+
+/*
+ * structdef for a rule on the combination of a feature with others
+ */
+typedef struct _mo_rule
+{
+    int feature;                /* feature the rule applies to (MO_FEAT_*) */
+    int excludes;               /* features it cannot be combined with */
+    int requires;               /* features it cannot be used without */
+    const char *message;        /* error if the rule is broken or NULL if the 
+                                   feature is turned off instead */
+} mo_rule_t;
+
+/*
+ * structdef for the header of tile cache entries, followed by the iteration 
+ * counts and the final values of z of all MO_CACHETILE x MO_CACHETILE pixels.
+ * pixels which were never computed have an iteration count of -1, those known
+ * to never diverge have a final z of NaN and a count of INT_MAX, so they reach
+ * the iteration maximum of every render
+ */
+typedef struct _mo_tile_header
+{
+    char magic[4];              /* "MOTC" */
+    int version;                /* MO_CACHEVERSION */
+    int max_iterations;         /* iteration maximum up to which the entry holds the 
+                                   final state of all of its pixels */
+} mo_tile_header_t;
+
+/*
+ * structdef for the header of checkpoints, followed by one bit per block of 
+ * the schedule which is set once the block is stored in the bitmap
+ */
+typedef struct _mo_checkpoint
+{
+    char magic[4];              /* "MOCP" */
+    int width, height;          /* image width/height */
+    int frame_count;            /* # of frames */
+    int max_iterations;         /* iteration maximum */
+    int blocksize, block_width; /* block size options */
+    int schedule;               /* block size schedule */
+    int workers;                /* # of processes the schedule was planned for */
+    int mirror;                 /* rows mirrored at the real axis (see mo_opts_t) */
+    int formula, julia;         /* iteration formula, julia set flag */
+    double julia_re, julia_im;  /* constant c of the julia set */
+    double min_re, min_im;      /* lower bounds of the region */
+    double axis_length;         /* absolute value range of x/y-axis */
+    int64_t block_count;        /* # of blocks of the schedule */
+} mo_checkpoint_t;
+
+/*
+ * structdef for the state of the master's tile cache lookups
+ */
+typedef struct _mo_cache
+{
+    int fd;                     /* file descriptor of the bitmap */
+    int *iterations;            /* buffer for iteration counts of cached blocks */
+    char *lines;                /* buffer for bitmap lines of cached blocks */
+    mo_scale_t *scale;          /* scalings of the render */
+    int64_t pixels;             /* # of pixels read from the cache */
+    int retval;                 /* EXIT_FAILURE if writing a cached block failed */
+} mo_cache_t;
+
+/*
+ * structdef for the master's queues of blocks sent to its slaves
+ */
+typedef struct _mo_slaves
+{
+    mo_block_t *blocks;         /* `depth` buffers of blocks sent to each slave */
+    MPI_Request *requests;      /* sends of the block buffers */
+    int *queued;                /* # of result messages expected from each slave */
+    int *sent;                  /* # of blocks sent to each slave */
+    int running;                /* # of result messages expected in total */
+} mo_slaves_t;
+
+/*
+ * structdef for the master's bitmaps of the frames
+ */
+typedef struct _mo_frames
+{
+    int *fds;                   /* file descriptor of each frame or -1 if not open */
+    int64_t *pixels;            /* # of pixels stored in each frame */
+    int current;                /* frame the colors are scaled for */
+    char *lines;                /* buffer for bitmap lines of a block */
+    mo_scale_t *scale;          /* scalings of the current frame */
+    unsigned char *done;        /* blocks stored for the checkpoint or NULL */
+} mo_frames_t;
+
+/*
+ * structdef for the chunks of a node leader, whose results are stored in 
+ * slots of the shared window following their header
+ */
+typedef struct _mo_chunk
+{
+    int used;                   /* if 1, the slot holds a chunk of the master */
+    int row;                    /* first row not handed out to a worker */
+    int pending;                /* # of blocks of workers not finished yet */
+    int *samples;               /* # of anti-aliased pixels of the blocks by first row */
+    MPI_Request request;        /* send of the result to the master */
+} mo_chunk_t;
+
+/*
+ * structdef for the state of the master's tile pyramid. tiles of all levels 
+ * are numbered level by level, starting with the computed tiles
+ */
+typedef struct _mo_pyramid
+{
+    int64_t *offsets;           /* # of the first tile of each level */
+    unsigned char *children;    /* # of finished children of each tile */
+    mo_block_t *pending;        /* tiles whose children are finished */
+    int pending_count;          /* # of pending tiles */
+    int *idle;                  /* slaves waiting for pending tiles */
+    int idle_count;             /* # of idle slaves */
+    int64_t remaining;          /* # of tiles not finished yet */
+} mo_pyramid_t;
+
+/*
+ * structdef for connections to the render server
+ */
+typedef struct _mo_client
+{
+    int fd;                     /* connection requests are read from or -1 if unused */
+    int reply_fd;               /* connection replies are written to */
+    int eof;                    /* if 1, the client closed its end */
+    int outstanding;            /* # of requests not replied to yet */
+    int length;                 /* # of bytes in buffer */
+    char buffer[MO_REQUESTLEN]; /* incomplete request line */
+} mo_client_t;
+
+/*
+ * structdef for the state of the render server
+ */
+typedef struct _mo_server
+{
+    int listen_fd;              /* listening socket or -1 if reading from stdin */
+    const char *path;           /* filename of the listening socket or NULL */
+    mo_client_t clients[MO_MAXCLIENTS]; /* connections */
+    mo_request_t defaults;      /* values of options missing in requests */
+    mo_request_t *pending;      /* requests waiting for the next batch */
+    int pending_count, pending_size; /* # of pending/allocated requests */
+    int quit;                   /* if 1, no more requests are accepted */
+} mo_server_t;
+
 /*
  * structdef for bmp header
  * derived from http://cpansearch.perl.org/src/DHUNT/PDL-Planet-0.05/libimage/bmp.c
@@ -124,12 +646,123 @@ typedef struct _mo_bmp_header
  * method prototypes 
  */
 static int parse_args(int, char **, mo_opts_t *, int, int);
-static void print_params(mo_opts_t *, double, double, double);
+static int check_features(char **, int, mo_opts_t *);
+static int supported(int, mo_opts_t *);
+static int active_features(mo_opts_t *);
+static int read_keyframes(const char *, int, mo_opts_t *);
+static void set_frame(int, mo_opts_t *);
+static int frame_format(const char *);
+static void frame_filename(char *, int, mo_opts_t *);
+static int auto_precision(mo_opts_t *);
+static void print_params(mo_opts_t *);
 static void print_usage(char **);
+static void init_blocks(mo_opts_t *);
+static void init_symmetry(mo_opts_t *);
+static int init_hierarchy(int, mo_opts_t *);
+static int serve(int, int, mo_opts_t *);
+static void set_batch(mo_request_t *, int, mo_opts_t *);
+static int open_server(mo_server_t *, mo_opts_t *);
+static void close_server(mo_server_t *);
+static int next_batch(mo_server_t *, mo_request_t *);
+static void poll_server(mo_server_t *, int);
+static void read_requests(mo_server_t *, int);
+static int parse_request(char *, mo_request_t *, mo_request_t *);
+static void reply_request(mo_server_t *, mo_request_t *, int);
+static void close_client(mo_client_t *);
+static void report_stats(int, int, mo_opts_t *);
+static inline double begin_event(mo_opts_t *);
+static inline void end_event(int, double, mo_block_t *, int *, mo_opts_t *);
+static void record_event(int, double, mo_block_t *, int *, mo_opts_t *);
+static void write_trace(int, int, mo_opts_t *);
 static int master_proc(int, mo_opts_t *);
-static int slave_proc(int, mo_opts_t *);
-static long mandelbrot(int, int, mo_scale_t *, mo_opts_t *);
-static inline void print_progress(int, int);
-static int write_bitmap(const char *, int, int, char *);
+static int64_t progress_total(mo_opts_t *);
+static int open_resumed(mo_frames_t *, int64_t *, mo_opts_t *);
+static int refill_slave(int, mo_slaves_t *, mo_sched_t *, mo_pyramid_t *, mo_cache_t *, 
+        unsigned char *, mo_opts_t *);
+static void release_slave(int, mo_pyramid_t *, int, mo_opts_t *);
+static void assign_idle(mo_slaves_t *, mo_pyramid_t *, int, mo_opts_t *);
+static int store_block(mo_block_header_t *, mo_frames_t *, mo_cache_t *, mo_opts_t *);
+static int snapshot_checkpoint(MPI_File, mo_checkpoint_t *, unsigned char *, size_t, 
+        MPI_Request *);
+static void close_checkpoint(MPI_File *, mo_checkpoint_t *, unsigned char *, size_t, 
+        MPI_Request *, mo_opts_t *);
+static int slave_proc(mo_opts_t *);
+static int rma_proc(int, mo_opts_t *);
+static int node_proc(mo_opts_t *);
+static int leader_proc(mo_opts_t *);
+static void finish_chunk(mo_block_header_t *, mo_chunk_t *, mo_opts_t *);
+static int queue_block(int, mo_sched_t *, mo_block_t *, MPI_Request *, mo_cache_t *, 
+        unsigned char *, mo_opts_t *);
+static int next_block(mo_sched_t *, mo_block_t *, int, mo_opts_t *);
+static int band_rows(int64_t, int, mo_opts_t *);
+static int mirrored_rows(mo_block_t *, mo_opts_t *);
+static int mirror_exact(int, mo_scale_t *, mo_scale_t *, mo_opts_t *, mo_opts_t *);
+static long double row_im(int, mo_scale_t *, mo_opts_t *);
+static inline int is_mirrored(int, mo_opts_t *);
+static int64_t schedule_blocks(unsigned char *, int64_t *, mo_opts_t *);
+static void plan_partition(int *, int, mo_scale_t *, mo_opts_t *);
+static int read_checkpoint(int, mo_opts_t *);
+static int load_checkpoint(mo_checkpoint_t *, unsigned char *, mo_opts_t *);
+static void init_checkpoint(mo_checkpoint_t *, int64_t, mo_opts_t *);
+static inline int lattice_offset(int64_t);
+static int write_cached_block(mo_block_t *, mo_cache_t *, mo_opts_t *);
+static int init_pyramid(mo_pyramid_t *, int, mo_opts_t *);
+static void finish_tile(mo_block_t *, mo_pyramid_t *, mo_opts_t *);
+static int queue_tile(int, mo_pyramid_t *, mo_block_t *, MPI_Request *);
+static inline void level_size(int, int *, int *, mo_opts_t *);
+static void tile_filename(char *, mo_block_t *, mo_opts_t *);
+static int write_tile(mo_block_t *, char *, int, mo_opts_t *);
+static int downsample_tile(mo_block_t *, char *, char *, mo_opts_t *);
+static void compute_cached(mo_block_t *, int *, mo_complex_t *, mo_scale_t *, mo_opts_t *);
+static void cache_filename(char *, mo_block_t *, int *, int *, mo_scale_t *, mo_opts_t *);
+static int cache_read(mo_block_t *, int *, mo_complex_t *, mo_scale_t *, mo_opts_t *);
+static int cache_write(mo_block_t *, int *, mo_complex_t *, mo_scale_t *, mo_opts_t *);
+static int read_tile(const char *, int *, mo_complex_t *);
+static void compute_rows(mo_block_t *, int *, const mo_kernel_t *, mo_scale_t *, mo_opts_t *);
+static void compute_mariani(mo_block_t *, int *, const mo_kernel_t *, mo_scale_t *, 
+        mo_opts_t *);
+static void mariani_silver(int, int, int, int, mo_block_t *, int *, const mo_kernel_t *, 
+        mo_scale_t *, mo_opts_t *);
+static void compute_progressive(mo_block_t *, int *, int *, int, const mo_kernel_t *, 
+        mo_scale_t *, mo_opts_t *);
+static inline int guess_pixel(int, int, int *, int, int);
+static void init_samples(mo_opts_t *, mo_scale_t *, mo_opts_t *);
+static int antialias_block(mo_block_t *, int *, int *, mo_sample_t *, const mo_kernel_t *, 
+        mo_scale_t *, mo_opts_t *);
+static inline int edge_pixel(int *, int);
+static void apply_samples(char *, mo_block_t *, mo_sample_t *, int, mo_opts_t *);
+static inline mo_sample_t *block_samples(mo_block_header_t *, mo_opts_t *);
+static int encode_block(mo_block_header_t *, int *, mo_sample_t *, mo_opts_t *);
+static int store_shared(mo_block_header_t *, int *, mo_sample_t *, mo_opts_t *);
+static void decode_block(mo_block_header_t *, char *, mo_scale_t *, mo_opts_t *);
+static void decode_grid(mo_block_header_t *, int *, int, mo_opts_t *);
+static int write_preview(int, int *, int, char *, mo_scale_t *, mo_opts_t *);
+static void color_block(int *, mo_block_t *, char *, mo_scale_t *, mo_opts_t *);
+static double count_iterations(int *, mo_block_t *, mo_opts_t *);
+static inline int block_line_size(int, mo_opts_t *);
+static inline int64_t result_size(mo_opts_t *);
+static inline void set_pixel(char *, int, long);
+static inline void set_value(void *, int, int, int);
+static inline int get_value(void *, int, int);
+static int mandelbrot(int, int, mo_scale_t *, mo_opts_t *);
+static int perturbation(int, int, mo_scale_t *, mo_opts_t *);
+static void perturbation_row(int, int, int, mo_scale_t *, mo_opts_t *, int *);
+static int reference_orbit(int, mo_opts_t *);
+static int compute_orbit(mo_orbit_t *, mo_opts_t *);
+static void series_approximation(mo_orbit_t *, mo_opts_t *);
+static int mandelbrot_resume(int, int, int, mo_complex_t *, mo_scale_t *, mo_opts_t *);
+static const mo_kernel_t *select_kernel(const char *, int, int);
+static const mo_kernel_t *pixel_kernel(mo_opts_t *);
+static void init_scale(mo_scale_t *, mo_opts_t *);
+static inline long pixel_color(int, mo_scale_t *, mo_opts_t *);
+static inline void print_progress(int64_t, int64_t);
+static inline int bitmap_line_size(int);
+static int64_t bitmap_header(unsigned char *, int, int);
+static int open_bitmap(const char *, int, int, int);
+static int open_bitmap_mpi(MPI_File *, int, int, mo_opts_t *);
+static inline int64_t bitmap_lines_offset(int, int, int, int);
+static int write_bitmap_block(int, char *, mo_block_t *, mo_opts_t *);
+static void write_bitmap_block_mpi(MPI_File, char *, mo_block_t *, MPI_Request *, mo_opts_t *);
+static int pwrite_all(int, const void *, int64_t, int64_t);
 
 #endif /* _MO_MANDELBROT_H */